@@ -0,0 +1,224 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+//bytes held by the arrays of aligned_allocator and huge_page_allocator, and the most held at once
+//since reset_peak(). Benchmarks add their other heap allocations to report the peak memory of a table
+class memory_counter {
+	public:
+		void add(size_t bytes) {
+			size_t now = current.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+			size_t high = peak.load(std::memory_order_relaxed);
+			while (now > high && !peak.compare_exchange_weak(high, now, std::memory_order_relaxed)) {}
+		}
+
+		void sub(size_t bytes) {
+			current.fetch_sub(bytes, std::memory_order_relaxed);
+		}
+
+		size_t get_current() const {
+			return current.load(std::memory_order_relaxed);
+		}
+
+		size_t get_peak() const {
+			return peak.load(std::memory_order_relaxed);
+		}
+
+		void reset_peak() {
+			peak.store(get_current(), std::memory_order_relaxed);
+		}
+
+	private:
+		std::atomic<size_t> current{ 0 };
+		std::atomic<size_t> peak{ 0 };
+};
+
+inline memory_counter& allocated_memory() {
+	static memory_counter counter;
+	return counter;
+}
+
+//smallest power of two >= size, at least alignment and at most one cache line.
+//Objects of that alignment never straddle a cache line unless they are larger than one
+constexpr size_t line_alignment(size_t size, size_t alignment) {
+	return alignment >= size || alignment >= 64 ? alignment : line_alignment(size, alignment * 2);
+}
+
+//allocator that places arrays on Align byte boundaries (default: one cache line)
+template<typename T, size_t Align = 64>
+struct aligned_allocator {
+	typedef T value_type;
+
+	template<typename U>
+	struct rebind {
+		typedef aligned_allocator<U, Align> other;
+	};
+
+	aligned_allocator() {}
+
+	template<typename U>
+	aligned_allocator(const aligned_allocator<U, Align>&) {}
+
+	T* allocate(size_t n) {
+		size_t bytes = (n * sizeof(T) + Align - 1) / Align * Align;
+#ifdef _MSC_VER
+		void* ptr = _aligned_malloc(bytes, Align);
+#else
+		void* ptr = nullptr;
+		if (posix_memalign(&ptr, Align, bytes) != 0)
+			ptr = nullptr;
+#endif
+		if (ptr == nullptr)
+			throw std::bad_alloc();
+		allocated_memory().add(bytes);
+		return static_cast<T*>(ptr);
+	}
+
+	void deallocate(T* ptr, size_t n) {
+		allocated_memory().sub((n * sizeof(T) + Align - 1) / Align * Align);
+#ifdef _MSC_VER
+		_aligned_free(ptr);
+#else
+		free(ptr);
+#endif
+	}
+};
+
+template<typename T, typename U, size_t Align>
+bool operator==(const aligned_allocator<T, Align>&, const aligned_allocator<U, Align>&) {
+	return true;
+}
+
+template<typename T, typename U, size_t Align>
+bool operator!=(const aligned_allocator<T, Align>&, const aligned_allocator<U, Align>&) {
+	return false;
+}
+
+//arrays of at least HUGE_PAGE_THRESHOLD bytes are mapped page-wise instead of taken from the heap
+const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+const size_t HUGE_PAGE_THRESHOLD = HUGE_PAGE_SIZE;
+
+#ifdef _WIN32
+
+//large pages need the "Lock pages in memory" privilege. Without it the first failure
+//switches to normal pages for the rest of the program
+inline void* map_pages(size_t bytes) {
+	static std::atomic<bool> large_pages_failed(false);
+	size_t large = GetLargePageMinimum();
+	if (large != 0 && !large_pages_failed.load(std::memory_order_relaxed)) {
+		void* ptr = VirtualAlloc(nullptr, (bytes + large - 1) / large * large,
+			MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+		if (ptr != nullptr)
+			return ptr;
+		large_pages_failed = true;
+	}
+	return VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+}
+
+inline void unmap_pages(void* ptr, size_t) {
+	VirtualFree(ptr, 0, MEM_RELEASE);
+}
+
+#else
+
+inline size_t mapped_size(size_t bytes) {
+	size_t page = (size_t)sysconf(_SC_PAGESIZE);
+	return (bytes + page - 1) / page * page;
+}
+
+//maps the array on a huge page boundary and asks for transparent huge pages. Without them
+//(disabled, or an OS without MADV_HUGEPAGE) the mapping simply keeps normal pages
+inline void* map_pages(size_t bytes) {
+	size_t mapped = mapped_size(bytes);
+	size_t length = mapped + HUGE_PAGE_SIZE;
+	void* raw = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (raw == MAP_FAILED)
+		return nullptr;
+
+	//give back the unaligned head and the unused tail
+	uintptr_t first = (uintptr_t)raw;
+	uintptr_t start = (first + HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(HUGE_PAGE_SIZE - 1);
+	if (start != first)
+		munmap(raw, start - first);
+	if (first + length != start + mapped)
+		munmap((void*)(start + mapped), first + length - start - mapped);
+#ifdef MADV_HUGEPAGE
+	madvise((void*)start, mapped, MADV_HUGEPAGE);
+#endif
+	return (void*)start;
+}
+
+inline void unmap_pages(void* ptr, size_t bytes) {
+	munmap(ptr, mapped_size(bytes));
+}
+
+#endif
+
+//allocator for the slot and bucket arrays of the tables. Small arrays come from aligned_allocator,
+//arrays of at least HUGE_PAGE_THRESHOLD bytes are mapped on a 2 MB boundary and backed by huge pages
+//where the OS allows it, so random probes into big tables miss the TLB far less often
+template<typename T>
+struct huge_page_allocator {
+	typedef T value_type;
+
+	template<typename U>
+	struct rebind {
+		typedef huge_page_allocator<U> other;
+	};
+
+	huge_page_allocator() {}
+
+	template<typename U>
+	huge_page_allocator(const huge_page_allocator<U>&) {}
+
+	static bool uses_pages(size_t n) {
+		return n * sizeof(T) >= HUGE_PAGE_THRESHOLD;
+	}
+
+	T* allocate(size_t n) {
+		if (!uses_pages(n))
+			return aligned_allocator<T>().allocate(n);
+		void* ptr = map_pages(n * sizeof(T));
+		if (ptr == nullptr)
+			throw std::bad_alloc();
+		allocated_memory().add(n * sizeof(T));
+		return static_cast<T*>(ptr);
+	}
+
+	void deallocate(T* ptr, size_t n) {
+		if (!uses_pages(n))
+			aligned_allocator<T>().deallocate(ptr, n);
+		else {
+			allocated_memory().sub(n * sizeof(T));
+			unmap_pages(ptr, n * sizeof(T));
+		}
+	}
+};
+
+template<typename T, typename U>
+bool operator==(const huge_page_allocator<T>&, const huge_page_allocator<U>&) {
+	return true;
+}
+
+template<typename T, typename U>
+bool operator!=(const huge_page_allocator<T>&, const huge_page_allocator<U>&) {
+	return false;
+}
@@ -0,0 +1,628 @@
+#include "aligned_allocator.h"
+#include "bulk_loader.h"
+#include "cuckoo_filter.h"
+#include "hash.h"
+#include "hashtable_adaptive.h"
+#include "hashtable_oa.h"
+#include "hashtable_persistent.h"
+#include "hashtable_sc.h"
+#include "parallel.h"
+#include "partitioned_set.h"
+#include "trace.h"
+#include "workload.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+#include <unordered_set>
+#include <vector>
+using namespace std;
+
+//benchmarks of the hash tables. Build in Release and run
+//	stlHashTableBench hash		throughput of the hash functions and their effect on the tables
+//	stlHashTableBench flood		cost per insert under collision flooding
+//	stlHashTableBench pages [MB]	random reads from heap and huge page backed arrays (default 1024 MB)
+//	stlHashTableBench persistent	snapshots and updates of the persistent set against copying tables
+//	stlHashTableBench filter		memory and speed of the cuckoo filter against the tables
+//	stlHashTableBench aggregate [T]	count distinct on T threads: merged value by value or partitioned
+//	stlHashTableBench load [MB] [T]	text file of MB megabytes (default 256) read line by line or with load_lines on T threads
+//	stlHashTableBench scan [M]	iteration and clear of a 10% full hashtable_oa with M million slots (default 100)
+//	stlHashTableBench workload [DIST] [MIX] [T]	all tables behind a mutex on 1 to T threads, DIST one of uniform,
+//					zipfian (default), hotspot and sequential, MIX reads/inserts/erases (default 90/5/5)
+//	stlHashTableBench replay FILE	runs a trace written by recorded_table (trace.h) against the tables
+
+typedef chrono::steady_clock bench_clock;
+
+double seconds_since(bench_clock::time_point start){
+	return chrono::duration<double>(bench_clock::now() - start).count();
+}
+
+//keeps the compiler from removing the benchmarked work
+volatile uint64_t bench_sink;
+
+void print_row(const string& name, double seconds, size_t ops, size_t bytes = 0){
+	cout << "  " << left << setw(36) << name << right << setw(10) << fixed << setprecision(2)
+		<< seconds * 1e9 / ops << " ns/op";
+	if(bytes)
+		cout << setw(10) << bytes / seconds / 1e9 << " GB/s";
+	cout << endl;
+}
+
+//every heap allocation of the benchmark is added to allocated_memory(), which already counts the
+//table arrays, so the replay can report the peak memory of the std::list nodes and std::unordered_set too.
+//The size is kept in front of the block because unsized operator delete does not get it
+const size_t ALLOCATION_HEADER = alignof(max_align_t);
+
+void* operator new(size_t bytes){
+	void* ptr = malloc(bytes + ALLOCATION_HEADER);
+	if(ptr == nullptr)
+		throw bad_alloc();
+	*(size_t*)ptr = bytes;
+	allocated_memory().add(bytes);
+	return (char*)ptr + ALLOCATION_HEADER;
+}
+
+void operator delete(void* ptr) noexcept{
+	if(ptr == nullptr)
+		return;
+	void* block = (char*)ptr - ALLOCATION_HEADER;
+	allocated_memory().sub(*(size_t*)block);
+	free(block);
+}
+
+void* operator new[](size_t bytes){
+	return operator new(bytes);
+}
+
+void operator delete[](void* ptr) noexcept{
+	operator delete(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept{
+	operator delete(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept{
+	operator delete(ptr);
+}
+
+// HASH FUNCTIONS ======================================================================================
+
+template<typename H>
+void bench_hash_integers(const string& name, const vector<uint64_t>& keys, size_t rounds){
+	auto start = bench_clock::now();
+	uint64_t sum = 0;
+	for(size_t r = 0; r < rounds; r++){
+		for(uint64_t key : keys)
+			sum += H()(key);
+	}
+	double seconds = seconds_since(start);
+	bench_sink = sum;
+	print_row(name, seconds, keys.size() * rounds);
+}
+
+template<typename H>
+void bench_hash_strings(const string& name, const vector<string>& keys, size_t rounds){
+	size_t bytes = 0;
+	auto start = bench_clock::now();
+	uint64_t sum = 0;
+	for(size_t r = 0; r < rounds; r++){
+		for(const string& key : keys){
+			sum += H()(key);
+			bytes += key.size();
+		}
+	}
+	double seconds = seconds_since(start);
+	bench_sink = sum;
+	print_row(name, seconds, keys.size() * rounds, bytes);
+}
+
+//inserts and looks up keys that are multiples of stride. Identity hashes such as std::hash<int>
+//put all of them into few buckets of a power of two or round capacity
+template<typename Table>
+void bench_table_keys(const string& name, int n, int stride){
+	auto start = bench_clock::now();
+	Table ht(16);
+	for(int i = 0; i < n; i++)
+		ht.insert(i * stride);
+	size_t found = 0;
+	for(int i = 0; i < n * 2; i++)
+		found += ht.contains(i * stride);
+	double seconds = seconds_since(start);
+	bench_sink = found;
+	print_row(name, seconds, n * 3);
+}
+
+void bench_hash(){
+	vector<uint64_t> integers;
+	for(uint64_t i = 0; i < 4096; i++)
+		integers.push_back(i * 0x9e3779b97f4a7c15ULL);
+	cout << "integers, " << integers.size() * 10000 << " hashes" << endl;
+	bench_hash_integers<std::hash<uint64_t>>("std::hash<uint64_t>", integers, 10000);
+	bench_hash_integers<default_hash<uint64_t>>("default_hash<uint64_t>", integers, 10000);
+	cout << endl;
+
+	for(size_t length : { 4, 16, 64, 1024 }){
+		vector<string> keys;
+		for(size_t i = 0; i < 1000; i++){
+			string key = to_string(i * 2654435761u);
+			key.resize(length, 'x');
+			keys.push_back(key);
+		}
+		size_t rounds = 20000000 / (length + 16);
+		cout << "strings of " << length << " bytes, " << keys.size() * rounds << " hashes" << endl;
+		bench_hash_strings<std::hash<string>>("std::hash<string>", keys, rounds);
+		bench_hash_strings<default_hash<string>>("default_hash<string>", keys, rounds);
+		cout << endl;
+	}
+
+	const int keys = 200000;
+	for(int stride : { 1, 1024 }){
+		cout << "tables, " << keys << " inserts and " << keys * 2 << " lookups of keys with stride " << stride << endl;
+		bench_table_keys<hashtable_sc<int, std::hash<int>>>("hashtable_sc, std::hash", keys, stride);
+		bench_table_keys<hashtable_sc<int>>("hashtable_sc, default_hash", keys, stride);
+		bench_table_keys<hashtable_oa<int, std::hash<int>>>("hashtable_oa, std::hash", keys, stride);
+		bench_table_keys<hashtable_oa<int>>("hashtable_oa, default_hash", keys, stride);
+		cout << endl;
+	}
+}
+
+// COLLISION FLOODING ==================================================================================
+
+//hash that an attacker has inverted: every key lands in the same bucket
+struct constant_hash {
+	size_t operator()(int) const {
+		return 5;
+	}
+};
+
+//key that cannot be hashed from its bytes, flood_guard stops at seeded hashing and the chain stays long
+struct ordered_key {
+	int id;
+
+	ordered_key(int id) : id(id) {}
+
+	bool operator==(const ordered_key& other) const {
+		return id == other.id;
+	}
+
+	bool operator<(const ordered_key& other) const {
+		return id < other.id;
+	}
+};
+
+struct constant_key_hash {
+	size_t operator()(const ordered_key&) const {
+		return 5;
+	}
+};
+
+void bench_flood(){
+	for(int n : { 1000, 10000, 100000 }){
+		cout << n << " inserts" << endl;
+		bench_table_keys<hashtable_sc<int>>("hashtable_sc, trusted keys", n, 1);
+		bench_table_keys<hashtable_sc<int, constant_hash>>("hashtable_sc, colliding keys", n, 1);
+		bench_table_keys<hashtable_sc<ordered_key, constant_key_hash>>("hashtable_sc, colliding, treeified", n, 1);
+		bench_table_keys<hashtable_oa<int>>("hashtable_oa, trusted keys", n, 1);
+		bench_table_keys<hashtable_oa<int, constant_hash>>("hashtable_oa, colliding keys", n, 1);
+		cout << endl;
+	}
+}
+
+// PAGE BACKED STORAGE =================================================================================
+
+//dependent random reads, so every read waits for its cache and TLB miss
+template<typename Vector>
+void bench_random_reads(const string& name, size_t bytes, size_t reads){
+	Vector values(bytes / sizeof(uint64_t));
+	size_t mask = 1;
+	while(mask * 2 <= values.size())
+		mask *= 2;
+	mask--;
+	for(size_t i = 0; i < values.size(); i++)
+		values[i] = mix64(i);
+
+	auto start = bench_clock::now();
+	uint64_t x = 0;
+	for(size_t i = 0; i < reads; i++)
+		x = values[(x ^ i) & mask];
+	double seconds = seconds_since(start);
+	bench_sink = x;
+	print_row(name, seconds, reads);
+}
+
+void bench_pages(size_t megabytes){
+	size_t bytes = megabytes << 20;
+	cout << "random reads from " << megabytes << " MB" << endl;
+	bench_random_reads<vector<uint64_t>>("std::allocator", bytes, 20000000);
+	bench_random_reads<vector<uint64_t, huge_page_allocator<uint64_t>>>("huge_page_allocator", bytes, 20000000);
+	cout << endl;
+}
+
+// CONTROL BYTE SCANS ==================================================================================
+
+void bench_scan(size_t million){
+	size_t slots = million * 1000000;
+	hashtable_oa<uint32_t> ht(16);
+	ht.rehash(slots);
+	for(uint32_t i = 0; i < slots / 10; i++)
+		ht.insert(i);
+	cout << ht.size() << " values in " << ht.capacity() << " slots" << endl;
+
+	auto start = bench_clock::now();
+	uint64_t sum = 0;
+	for(uint32_t value : ht)
+		sum += value;
+	double seconds = seconds_since(start);
+	bench_sink = sum;
+	print_row("iteration, per slot", seconds, slots, slots);
+
+	start = bench_clock::now();
+	ht.clear();
+	print_row("clear, per slot", seconds_since(start), slots, slots);
+	cout << endl;
+}
+
+// PERSISTENT SET ======================================================================================
+
+template<typename Table>
+void bench_table_snapshots(const string& name, int n, int snapshots){
+	Table ht(16);
+	for(int i = 0; i < n; i++)
+		ht.insert(i);
+	auto start = bench_clock::now();
+	size_t sizes = 0;
+	for(int i = 0; i < snapshots; i++){
+		Table snapshot(ht);
+		sizes += snapshot.size();
+	}
+	double seconds = seconds_since(start);
+	bench_sink = sizes;
+	print_row(name, seconds, snapshots);
+}
+
+void bench_persistent(){
+	const int n = 1000000;
+	cout << n << " inserts" << endl;
+	auto start = bench_clock::now();
+	hashtable_persistent<int> set;
+	for(int i = 0; i < n; i++)
+		set = set.insert(i);
+	print_row("hashtable_persistent::insert", seconds_since(start), n);
+
+	start = bench_clock::now();
+	hashtable_persistent<int>::builder builder = hashtable_persistent<int>().transient();
+	for(int i = 0; i < n; i++)
+		builder.insert(i);
+	hashtable_persistent<int> built = builder.persistent();
+	print_row("hashtable_persistent::builder", seconds_since(start), n);
+
+	start = bench_clock::now();
+	hashtable_sc<int> sc(16);
+	for(int i = 0; i < n; i++)
+		sc.insert(i);
+	print_row("hashtable_sc", seconds_since(start), n);
+	cout << endl;
+
+	cout << n * 2 << " lookups" << endl;
+	start = bench_clock::now();
+	size_t found = 0;
+	for(int i = 0; i < n * 2; i++)
+		found += built.contains(i);
+	print_row("hashtable_persistent", seconds_since(start), n * 2);
+	start = bench_clock::now();
+	for(int i = 0; i < n * 2; i++)
+		found += sc.contains(i);
+	print_row("hashtable_sc", seconds_since(start), n * 2);
+	bench_sink = found;
+	cout << endl;
+
+	cout << "snapshots of " << n << " values" << endl;
+	start = bench_clock::now();
+	size_t sizes = 0;
+	for(int i = 0; i < 1000000; i++){
+		hashtable_persistent<int> snapshot(built);
+		sizes += snapshot.size();
+	}
+	bench_sink = sizes;
+	print_row("hashtable_persistent", seconds_since(start), 1000000);
+	bench_table_snapshots<hashtable_sc<int>>("hashtable_sc", n, 5);
+	bench_table_snapshots<hashtable_oa<int>>("hashtable_oa", n, 5);
+	cout << endl;
+}
+
+// APPROXIMATE MEMBERSHIP ==============================================================================
+
+//inserts n keys and looks up n keys of which half were inserted. Memory is everything the table
+//allocated, the filter takes its whole array in the constructor
+template<typename Table, typename Make>
+void bench_membership(const string& name, Make make, int n){
+	size_t baseline = allocated_memory().get_current();
+	Table ht = make();
+	auto start = bench_clock::now();
+	for(int i = 0; i < n; i++)
+		ht.insert(mix64(i));
+	double insert_seconds = seconds_since(start);
+	size_t bytes = allocated_memory().get_current() - baseline;
+
+	start = bench_clock::now();
+	size_t found = 0;
+	for(int i = n / 2; i < n + n / 2; i++)
+		found += ht.contains(mix64(i));
+	double lookup_seconds = seconds_since(start);
+	bench_sink = found;
+
+	print_row(name + " insert", insert_seconds, n);
+	print_row(name + " contains", lookup_seconds, n);
+	cout << "    " << setprecision(1) << bytes / 1048576.0 << " MB, " << bytes * 8.0 / n << " bits per key, "
+		<< found - n / 2 << " false positives" << endl;
+}
+
+void bench_filter(){
+	const int n = 1000000;
+	cout << n << " keys" << endl;
+	bench_membership<hashtable_sc<uint64_t>>("hashtable_sc", []() { return hashtable_sc<uint64_t>(16); }, n);
+	bench_membership<hashtable_oa<uint64_t>>("hashtable_oa", []() { return hashtable_oa<uint64_t>(16); }, n);
+	bench_membership<cuckoo_filter<uint64_t>>("cuckoo_filter 1%", [=]() { return cuckoo_filter<uint64_t>(n, 0.01); }, n);
+	bench_membership<cuckoo_filter<uint64_t>>("cuckoo_filter 0.01%", [=]() { return cuckoo_filter<uint64_t>(n, 0.0001); }, n);
+	cout << endl;
+}
+
+// PARALLEL AGGREGATION ================================================================================
+
+void bench_aggregate(unsigned threads){
+	const size_t n = 8000000;
+	const size_t distinct = 2000000;
+	cout << n << " values, " << distinct << " distinct, " << threads << " threads" << endl;
+
+	//every thread fills its own table, one thread merges them value by value
+	auto start = bench_clock::now();
+	vector<hashtable_oa<uint64_t>> tables(threads, hashtable_oa<uint64_t>(16));
+	parallel_for(par(threads), n, [&](size_t chunk, size_t first, size_t last){
+		for(size_t i = first; i < last; i++)
+			tables[chunk].insert(mix64(i) % distinct);
+	});
+	double fill = seconds_since(start);
+	start = bench_clock::now();
+	hashtable_oa<uint64_t> result(16);
+	for(const hashtable_oa<uint64_t>& table : tables)
+		result.merge(table);
+	double merge = seconds_since(start);
+	print_row("hashtable_oa fill", fill, n);
+	print_row("hashtable_oa merge", merge, n);
+	bench_sink = result.size();
+
+	//partitioned tables, partition i of every thread merged by one thread
+	start = bench_clock::now();
+	vector<partitioned_set<uint64_t>> locals(threads);
+	parallel_for(par(threads), n, [&](size_t chunk, size_t first, size_t last){
+		for(size_t i = first; i < last; i++)
+			locals[chunk].insert(mix64(i) % distinct);
+	});
+	fill = seconds_since(start);
+	start = bench_clock::now();
+	partitioned_set<uint64_t> merged = partitioned_set<uint64_t>::merge(locals, par(threads));
+	merge = seconds_since(start);
+	print_row("partitioned_set fill", fill, n);
+	print_row("partitioned_set merge", merge, n);
+	bench_sink = merged.size();
+	if(merged.size() != result.size())
+		cout << "  different results: " << merged.size() << " and " << result.size() << endl;
+	cout << endl;
+}
+
+// BULK LOADING ========================================================================================
+
+//writes about megabytes MB of keys, one per line with a quarter of them repeated, loads them line by line
+//into hashtable_oa and with load_lines into partitioned sets. The first run also pulls the file into the page cache
+void bench_load(size_t megabytes, unsigned threads){
+	const string path = "stlHashTableBench.load.txt";
+	size_t lines = 0, bytes = 0;
+	{
+		ofstream out(path, ios::binary | ios::trunc);
+		for(; bytes < megabytes * 1048576; lines++){
+			string key = "key" + to_string(mix64(lines * 3 / 4));
+			out << key << "\n";
+			bytes += key.size() + 1;
+		}
+	}
+	cout << lines << " lines, " << bytes / 1048576 << " MB, " << threads << " threads" << endl;
+
+	auto start = bench_clock::now();
+	hashtable_oa<string> table(16);
+	{
+		ifstream in(path, ios::binary);
+		string line;
+		while(getline(in, line))
+			table.insert(line);
+	}
+	print_row("getline + hashtable_oa::insert", seconds_since(start), lines, bytes);
+	bench_sink = table.size();
+
+	start = bench_clock::now();
+	partitioned_set<string> sequential;
+	load_lines(path, sequential, seq);
+	print_row("load_lines seq", seconds_since(start), lines, bytes);
+
+	start = bench_clock::now();
+	partitioned_set<string> parallel;
+	load_lines(path, parallel, par(threads));
+	print_row("load_lines par", seconds_since(start), lines, bytes);
+
+	start = bench_clock::now();
+	partitioned_set<string, default_hash<string>, equal_to<string>, hashtable_sc<string>> chains;
+	load_lines(path, chains, par(threads));
+	print_row("load_lines par, hashtable_sc", seconds_since(start), lines, bytes);
+	if(parallel.size() != table.size() || sequential.size() != table.size() || chains.size() != table.size())
+		cout << "  different results: " << table.size() << ", " << sequential.size() << ", " << parallel.size()
+			<< " and " << chains.size() << endl;
+	remove(path.c_str());
+	cout << endl;
+}
+
+// WORKLOAD ============================================================================================
+
+template<typename Table>
+void bench_workload_table(const string& name, workload_config config){
+	Table table(16);
+	locked_table<Table> locked(table);
+	workload_result result = run_workload(locked, config);
+	print_row(name + ", " + to_string(config.threads) + " threads", result.seconds, result.operations);
+	cout << "    " << setprecision(2) << result.operations_per_second() / 1e6 << " Mops/s, latency ns";
+	const char* names[] = { "p50", "p90", "p99", "p99.9" };
+	const double percentiles[] = { 0.5, 0.9, 0.99, 0.999 };
+	for(int i = 0; i < 4; i++)
+		cout << " " << names[i] << " " << setprecision(0) << result.latencies.percentile_ns(percentiles[i]);
+	cout << " max " << result.latencies.max_ns() << endl;
+}
+
+//every table behind one mutex with 1, 2, 4 ... threads threads, 2 million operations per run
+void bench_workload(const string& distribution, const string& mix, unsigned threads){
+	workload_config config;
+	config.key_space = 1000000;
+	const char* distributions[] = { "uniform", "zipfian", "hotspot", "sequential" };
+	int d = uniform_keys;
+	while(d <= sequential_keys && distribution != distributions[d])
+		d++;
+	if(d > sequential_keys){
+		cout << "unknown distribution " << distribution << endl;
+		return;
+	}
+	config.distribution = (key_distribution)d;
+	if(sscanf(mix.c_str(), "%lf/%lf/%lf", &config.reads, &config.inserts, &config.erases) != 3){
+		cout << "the mix is reads/inserts/erases, e.g. 90/5/5" << endl;
+		return;
+	}
+	cout << distributions[config.distribution] << " keys from " << config.key_space << ", reads/inserts/erases "
+		<< mix << ", up to " << threads << " threads" << endl;
+
+	for(unsigned t = 1; ; t = min(t * 2, threads)){
+		config.threads = t;
+		config.operations = 2000000 / t;
+		bench_workload_table<hashtable_sc<uint64_t>>("hashtable_sc", config);
+		bench_workload_table<hashtable_oa<uint64_t>>("hashtable_oa", config);
+		bench_workload_table<hashtable_adaptive<uint64_t>>("hashtable_adaptive", config);
+		bench_workload_table<unordered_set<uint64_t>>("std::unordered_set", config);
+		if(t == threads) break;
+	}
+	cout << endl;
+}
+
+// TRACE REPLAY ========================================================================================
+
+template<typename Table>
+void replay_record(Table& ht, const trace_record& record, size_t& found){
+	switch(record.kind){
+	case trace_insert:
+		ht.insert(record.key);
+		break;
+	case trace_erase:
+		ht.erase(record.key);
+		break;
+	case trace_contains:
+		found += table_contains(ht, record.key);
+		break;
+	case trace_rehash:
+		ht.rehash(record.key);
+		break;
+	}
+}
+
+//one untimed-per-operation run for throughput and peak memory, a second one that times every
+//operation for the latency percentiles. The clock reads would distort the throughput otherwise
+template<typename Table>
+void bench_replay_table(const string& name, const trace& t, Table first, Table second){
+	size_t found = 0;
+	size_t baseline = allocated_memory().get_current();
+	allocated_memory().reset_peak();
+	auto start = bench_clock::now();
+	for(const trace_record& record : t.records)
+		replay_record(first, record, found);
+	double seconds = seconds_since(start);
+	size_t peak = allocated_memory().get_peak() - baseline;
+
+	vector<uint32_t> latencies(t.records.size());
+	for(size_t i = 0; i < t.records.size(); i++){
+		auto op_start = bench_clock::now();
+		replay_record(second, t.records[i], found);
+		latencies[i] = (uint32_t)min<int64_t>(UINT32_MAX,
+			chrono::duration_cast<chrono::nanoseconds>(bench_clock::now() - op_start).count());
+	}
+	bench_sink = found;
+	sort(latencies.begin(), latencies.end());
+
+	print_row(name, seconds, t.records.size());
+	cout << "    " << setprecision(1) << t.records.size() / seconds / 1e6 << " Mops/s, peak memory "
+		<< peak / 1048576.0 << " MB, latency ns";
+	const char* names[] = { "p50", "p90", "p99", "p99.9" };
+	const double percentiles[] = { 0.5, 0.9, 0.99, 0.999 };
+	for(int i = 0; i < 4; i++)
+		cout << " " << names[i] << " " << latencies[(size_t)(percentiles[i] * (latencies.size() - 1))];
+	cout << " max " << latencies.back() << endl;
+}
+
+void bench_replay(const string& path){
+	trace t;
+	if(!read_trace(path, t)){
+		cout << "cannot read trace " << path << endl;
+		return;
+	}
+	if(t.records.empty()){
+		cout << "trace " << path << " is empty" << endl;
+		return;
+	}
+	size_t counts[4] = { 0, 0, 0, 0 };
+	for(const trace_record& record : t.records)
+		counts[record.kind]++;
+	cout << "trace " << path << ", " << t.records.size() << " operations ("
+		<< (t.keys == trace_raw_keys ? "raw" : "hashed") << " keys): " << counts[trace_insert] << " inserts, "
+		<< counts[trace_erase] << " erases, " << counts[trace_contains] << " lookups, "
+		<< counts[trace_rehash] << " rehashes" << endl;
+
+	bench_replay_table("hashtable_sc", t, hashtable_sc<uint64_t>(16), hashtable_sc<uint64_t>(16));
+	bench_replay_table("hashtable_oa", t, hashtable_oa<uint64_t>(16), hashtable_oa<uint64_t>(16));
+	bench_replay_table("std::unordered_set", t, unordered_set<uint64_t>(), unordered_set<uint64_t>());
+	cout << endl;
+}
+
+
+
+
+int main(int argc, char** argv) {
+	string command = argc > 1 ? argv[1] : "hash";
+
+	if(command == "hash")
+		bench_hash();
+	else if(command == "flood")
+		bench_flood();
+	else if(command == "pages")
+		bench_pages(argc > 2 ? stoul(argv[2]) : 1024);
+	else if(command == "scan")
+		bench_scan(argc > 2 ? stoul(argv[2]) : 100);
+	else if(command == "persistent")
+		bench_persistent();
+	else if(command == "filter")
+		bench_filter();
+	else if(command == "aggregate")
+		bench_aggregate(argc > 2 ? stoul(argv[2]) : par().threads);
+	else if(command == "load")
+		bench_load(argc > 2 ? stoul(argv[2]) : 256, argc > 3 ? stoul(argv[3]) : par().threads);
+	else if(command == "workload")
+		bench_workload(argc > 2 ? argv[2] : "zipfian", argc > 3 ? argv[3] : "90/5/5", argc > 4 ? stoul(argv[4]) : par().threads);
+	else if(command == "replay" && argc > 2)
+		bench_replay(argv[2]);
+	else {
+		cout << "unknown benchmark " << command << endl;
+		cout << "usage: stlHashTableBench [hash | flood | pages [MB] | scan [M] | persistent | filter | aggregate [T] | load [MB] [T] | workload [DIST] [MIX] [T] | replay FILE]" << endl;
+		return 1;
+	}
+	return 0;
+}
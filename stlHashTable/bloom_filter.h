@@ -0,0 +1,91 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "aligned_allocator.h"
+#include "hash.h"
+
+//Bloom filter split into 512 bit blocks, one cache line each.
+//All bits of a key are set in the same block, so a lookup touches a single cache line.
+//A default constructed filter is disabled and must not be queried.
+class blocked_bloom_filter {
+	public:
+
+		blocked_bloom_filter() : n_blocks(0), n_hashes(0) {}
+
+		//expected: number of keys the filter is dimensioned for
+		//fp_rate: target false positive rate at that many keys, clamped to [1e-9, 0.5]
+		//max_bytes: memory budget, 0 -> unlimited
+		blocked_bloom_filter(size_t expected, double fp_rate, size_t max_bytes = 0) {
+			fp_rate = std::min(std::max(fp_rate, 1e-9), 0.5);
+			double ln2 = std::log(2.0);
+			//blocking skews the bit distribution, about 20% more bits keep the target rate
+			double bits_per_key = -std::log(fp_rate) / (ln2 * ln2) * 1.2;
+
+			n_hashes = (int)std::lround(-std::log2(fp_rate));
+			n_hashes = std::min(std::max(n_hashes, 1), 16);
+
+			n_blocks = (size_t)std::ceil(std::max<size_t>(expected, 1) * bits_per_key / BLOCK_BITS);
+			if (max_bytes != 0)
+				n_blocks = std::min(n_blocks, std::max<size_t>(max_bytes / BLOCK_BYTES, 1));
+			n_blocks = std::max<size_t>(n_blocks, 1);
+
+			blocks.assign(n_blocks * BLOCK_WORDS, 0);
+		}
+
+		void add(uint64_t hash) {
+			uint64_t mask[BLOCK_WORDS];
+			uint64_t* block = &blocks[locate(hash, mask)];
+			for (size_t i = 0; i < BLOCK_WORDS; i++)
+				block[i] |= mask[i];
+		}
+
+		//false -> the key was never added, true -> the key was probably added
+		bool may_contain(uint64_t hash) const {
+			uint64_t mask[BLOCK_WORDS];
+			const uint64_t* block = &blocks[locate(hash, mask)];
+			for (size_t i = 0; i < BLOCK_WORDS; i++) {
+				if ((block[i] & mask[i]) != mask[i])
+					return false;
+			}
+			return true;
+		}
+
+		void clear() {
+			std::fill(blocks.begin(), blocks.end(), 0);
+		}
+
+		bool enabled() const {
+			return n_blocks != 0;
+		}
+
+		size_t memory() const {
+			return n_blocks * BLOCK_BYTES;
+		}
+
+	private:
+		static const size_t BLOCK_BYTES = 64;
+		static const size_t BLOCK_BITS = BLOCK_BYTES * 8;
+		static const size_t BLOCK_WORDS = BLOCK_BYTES / sizeof(uint64_t);
+
+		std::vector<uint64_t, huge_page_allocator<uint64_t>> blocks;
+		size_t n_blocks;
+		int n_hashes;
+
+		//returns the offset of the key's block and fills mask with the bits of the key inside the block
+		size_t locate(uint64_t hash, uint64_t* mask) const {
+			uint64_t h = mix64(hash);
+			size_t index = (size_t)(((h >> 32) * n_blocks) >> 32);
+
+			//double hashing over the 512 bits of the block
+			uint32_t a = (uint32_t)h;
+			uint32_t b = (uint32_t)(mix64(h) >> 32) | 1;
+			std::fill(mask, mask + BLOCK_WORDS, 0);
+			for (int i = 0; i < n_hashes; i++) {
+				uint32_t bit = (a + i * b) & (BLOCK_BITS - 1);
+				mask[bit / 64] |= uint64_t(1) << (bit % 64);
+			}
+			return index * BLOCK_WORDS;
+		}
+};
@@ -0,0 +1,333 @@
+#pragma once
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "hash.h"
+#include "parallel.h"
+#include "partitioned_set.h"
+
+
+
+//parallel bulk loading of a partitioned_set from a file. The file is mapped instead of read and
+//processed in windows of LOAD_WINDOW bytes: every worker takes a chunk of the window, cut on record
+//boundaries, parses and hashes its records and sorts them by partition. Then every worker inserts
+//whole partitions, so no two threads touch the same table and no lock is taken.
+//String keys stay views into the mapping. For the duplicate check a worker copies a key into one reused
+//buffer, so only keys that are not stored yet are allocated as a std::string and moved into the table.
+//With hashtable_sc partitions, partitioned_set<V, H, C, hashtable_sc<V, H, C>>, the same path fills chains
+const size_t LOAD_WINDOW = 64 * 1024 * 1024;
+
+//read-only mapping of a whole file. An empty file is valid and has no data
+class mapped_file {
+
+	public:
+		explicit mapped_file(const std::string& path);
+		~mapped_file();
+		mapped_file(const mapped_file&) = delete;
+		mapped_file& operator=(const mapped_file&) = delete;
+
+		bool valid() const;
+		const char* data() const;
+		size_t size() const;
+
+	private:
+		const char* bytes;
+		size_t length;
+		bool ok;
+#ifdef _WIN32
+		HANDLE file;
+		HANDLE mapping;
+#else
+		int fd;
+#endif
+};
+
+//how records become values: parse_text() reads a line, read_binary() sizeof(V) bytes. The workers keep
+//a key_type per record, make() builds the value, for string keys assign() overwrites a reused one.
+//hash<H>() equals H()(make(key))
+template<typename V, typename Enable = void>
+struct record_traits;
+
+template<typename V>
+struct record_traits<V, typename std::enable_if<std::is_integral<V>::value>::type> {
+	typedef V key_type;
+
+	//decimal, the whole line has to be the number
+	static bool parse_text(const char* first, const char* last, V& key) {
+		std::from_chars_result result = std::from_chars(first, last, key);
+		return result.ec == std::errc() && result.ptr == last;
+	}
+
+	static V read_binary(const char* record) {
+		V key;
+		std::memcpy(&key, record, sizeof(V));
+		return key;
+	}
+
+	static V make(V key) {
+		return key;
+	}
+
+	template<typename H>
+	static size_t hash(V key) {
+		return H()(key);
+	}
+};
+
+template<>
+struct record_traits<std::string> {
+	typedef std::string_view key_type;
+
+	static bool parse_text(const char* first, const char* last, std::string_view& key) {
+		key = std::string_view(first, (size_t)(last - first));
+		return true;
+	}
+
+	static std::string make(std::string_view key) {
+		return std::string(key);
+	}
+
+	//keeps the capacity of value, no allocation once it is large enough
+	static void assign(std::string& value, std::string_view key) {
+		value.assign(key.data(), key.size());
+	}
+
+	//default_hash hashes the characters either way, other functors only get a std::string if they need one
+	template<typename H>
+	static size_t hash(std::string_view key) {
+		if constexpr (std::is_same<H, default_hash<std::string>>::value)
+			return default_hash<std::string_view>()(key);
+		else if constexpr (std::is_invocable<H, std::string_view>::value)
+			return H()(key);
+		else
+			return H()(std::string(key));
+	}
+};
+
+//adds the lines of a text file to set, one value per line: std::string or decimal integers.
+//"\r\n" line ends are accepted and empty lines skipped. Returns false if the file cannot be mapped
+//or a line is no valid value, the other lines are loaded anyway. An empty set is presized from the
+//record count of the first window
+template<typename V, typename H, typename C, typename T>
+bool load_lines(const std::string& path, partitioned_set<V, H, C, T>& set, execution_policy policy = par(), size_t window = LOAD_WINDOW);
+
+//adds the values of a binary file of native endian integers, sizeof(V) bytes each, to set.
+//Returns false if the file cannot be mapped or ends with a partial record
+template<typename V, typename H, typename C, typename T>
+bool load_binary(const std::string& path, partitioned_set<V, H, C, T>& set, execution_policy policy = par(), size_t window = LOAD_WINDOW);
+
+//==========  DEFINITION OF MAPPED FILE ==============
+
+#ifdef _WIN32
+
+inline mapped_file::mapped_file(const std::string& path) : bytes(nullptr), length(0), ok(false), mapping(nullptr) {
+	file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	LARGE_INTEGER file_size;
+	if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &file_size))
+		return;
+	length = (size_t)file_size.QuadPart;
+	if (length == 0) {
+		ok = true;
+		return;
+	}
+	mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr)
+		return;
+	bytes = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	ok = bytes != nullptr;
+}
+
+inline mapped_file::~mapped_file() {
+	if (bytes != nullptr)
+		UnmapViewOfFile(bytes);
+	if (mapping != nullptr)
+		CloseHandle(mapping);
+	if (file != INVALID_HANDLE_VALUE)
+		CloseHandle(file);
+}
+
+#else
+
+inline mapped_file::mapped_file(const std::string& path) : bytes(nullptr), length(0), ok(false) {
+	fd = open(path.c_str(), O_RDONLY);
+	struct stat info;
+	if (fd < 0 || fstat(fd, &info) != 0)
+		return;
+	length = (size_t)info.st_size;
+	if (length == 0) {
+		ok = true;
+		return;
+	}
+	void* mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (mapped == MAP_FAILED)
+		return;
+	bytes = (const char*)mapped;
+	ok = true;
+}
+
+inline mapped_file::~mapped_file() {
+	if (bytes != nullptr)
+		munmap((void*)bytes, length);
+	if (fd >= 0)
+		close(fd);
+}
+
+#endif
+
+inline bool mapped_file::valid() const {
+	return ok;
+}
+
+inline const char* mapped_file::data() const {
+	return bytes;
+}
+
+inline size_t mapped_file::size() const {
+	return ok ? length : 0;
+}
+
+//==========  DEFINITION OF BULK LOAD ==============
+
+//the window loop shared by both formats. boundary(pos) is the first record boundary at or after pos,
+//parse(first, last, emit) calls emit(key) for every record in [first, last) and returns false on bad records
+template<typename V, typename H, typename C, typename T, typename B, typename P>
+bool bulk_load(partitioned_set<V, H, C, T>& set, size_t end, execution_policy policy, size_t window, B boundary, P parse) {
+	typedef typename record_traits<V>::key_type key_type;
+	size_t chunks = chunk_count(policy);
+	size_t parts = set.partition_count();
+	//keys of chunk c for partition p in records[c * parts + p], reused by every window
+	std::vector<std::vector<key_type>> records(chunks * parts);
+	std::vector<char> chunk_ok(chunks, 1);
+	bool presize = set.empty();
+	window = std::max<size_t>(window, 1);
+
+	for (size_t first = 0; first < end; ) {
+		size_t last = boundary(std::min(end, first + window));
+
+		parallel_for(policy, chunks, [&](size_t, size_t from, size_t to) {
+			for (size_t c = from; c < to; c++) {
+				size_t begin = boundary(first + (last - first) * c / chunks);
+				size_t stop = boundary(first + (last - first) * (c + 1) / chunks);
+				std::vector<key_type>* own = &records[c * parts];
+				for (size_t p = 0; p < parts; p++)
+					own[p].clear();
+				bool ok = parse(begin, stop, [&](const key_type& key) {
+					own[set.partition_of_hash(record_traits<V>::template hash<H>(key))].push_back(key);
+				});
+				if (!ok) chunk_ok[c] = 0;
+			}
+		});
+
+		//the first window tells how many records the whole file has
+		size_t expected = 0;
+		if (presize) {
+			for (const std::vector<key_type>& keys : records)
+				expected += keys.size();
+			expected = (size_t)((double)expected * end / (last - first));
+			presize = false;
+		}
+
+		parallel_for(policy, parts, [&](size_t, size_t from, size_t to) {
+			V scratch = V();
+			for (size_t p = from; p < to; p++) {
+				T& table = set.partition(p);
+				size_t capacity = expected / parts * 4 / 3 + 16;
+				//rehash keeps the partition's filter, cache and guard settings
+				if (expected != 0 && table.capacity() < capacity)
+					table.rehash(capacity);
+				for (size_t c = 0; c < chunks; c++) {
+					for (const key_type& key : records[c * parts + p]) {
+						if constexpr (std::is_same<key_type, V>::value) {
+							table.insert(record_traits<V>::make(key));
+						} else {
+							//a duplicate only costs the copy into scratch, a new value takes over its buffer
+							record_traits<V>::assign(scratch, key);
+							if (!table.contains(scratch))
+								table.insert(std::move(scratch));
+						}
+					}
+				}
+			}
+		});
+		first = last;
+	}
+	return std::find(chunk_ok.begin(), chunk_ok.end(), 0) == chunk_ok.end();
+}
+
+template<typename V, typename H, typename C, typename T>
+bool load_lines(const std::string& path, partitioned_set<V, H, C, T>& set, execution_policy policy, size_t window) {
+	typedef typename record_traits<V>::key_type key_type;
+	mapped_file file(path);
+	if (!file.valid())
+		return false;
+	const char* data = file.data();
+	size_t size = file.size();
+
+	//a record starts after a line end, a position inside a line moves to the start of the next one
+	auto boundary = [data, size](size_t pos) -> size_t {
+		if (pos == 0 || pos >= size)
+			return std::min(pos, size);
+		const void* line_end = std::memchr(data + pos - 1, '\n', size - pos + 1);
+		return line_end == nullptr ? size : (size_t)((const char*)line_end - data) + 1;
+	};
+	auto parse = [data](size_t first, size_t last, auto emit) -> bool {
+		bool ok = true;
+		const char* line = data + first;
+		const char* stop = data + last;
+		while (line < stop) {
+			const char* line_end = (const char*)std::memchr(line, '\n', (size_t)(stop - line));
+			if (line_end == nullptr)
+				line_end = stop;
+			const char* key_end = line_end > line && line_end[-1] == '\r' ? line_end - 1 : line_end;
+			key_type key;
+			if (key_end > line) {
+				if (record_traits<V>::parse_text(line, key_end, key))
+					emit(key);
+				else
+					ok = false;
+			}
+			line = line_end + 1;
+		}
+		return ok;
+	};
+	return bulk_load(set, size, policy, window, boundary, parse);
+}
+
+template<typename V, typename H, typename C, typename T>
+bool load_binary(const std::string& path, partitioned_set<V, H, C, T>& set, execution_policy policy, size_t window) {
+	mapped_file file(path);
+	if (!file.valid())
+		return false;
+	const char* data = file.data();
+	size_t end = file.size() / sizeof(V) * sizeof(V);
+
+	auto boundary = [](size_t pos) -> size_t {
+		return (pos + sizeof(V) - 1) / sizeof(V) * sizeof(V);
+	};
+	auto parse = [data](size_t first, size_t last, auto emit) -> bool {
+		for (size_t pos = first; pos < last; pos += sizeof(V))
+			emit(record_traits<V>::read_binary(data + pos));
+		return true;
+	};
+	bool ok = bulk_load(set, end, policy, window, boundary, parse);
+	return ok && end == file.size();
+}
@@ -0,0 +1,117 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+//scans over the packed control bytes of open addressing tables, one byte of metadata per slot.
+//With AVX2 32 and with SSE2 16 slots are compared per step and turned into a bit mask,
+//so sparse tables are scanned at memory bandwidth instead of one branch per slot.
+//Without SSE2, or with CONTROL_BYTES_SCALAR defined, the plain loops run
+#ifndef CONTROL_BYTES_SCALAR
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define CONTROL_BYTES_AVX2
+#define CONTROL_BYTES_SSE2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CONTROL_BYTES_SSE2
+#endif
+#endif
+
+//index of the lowest set bit, mask must not be 0
+inline unsigned lowest_bit(uint32_t mask) {
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return (unsigned)index;
+#else
+	return (unsigned)__builtin_ctz(mask);
+#endif
+}
+
+inline unsigned popcount32(uint32_t x) {
+	x = x - ((x >> 1) & 0x55555555);
+	x = (x & 0x33333333) + ((x >> 2) & 0x33333333);
+	return (((x + (x >> 4)) & 0x0f0f0f0f) * 0x01010101) >> 24;
+}
+
+//bit i is set if ctrl[i] == value, for 32 (AVX2) or 16 (SSE2) bytes
+#ifdef CONTROL_BYTES_AVX2
+inline uint32_t match_32(const unsigned char* ctrl, unsigned char value) {
+	__m256i bytes = _mm256_loadu_si256((const __m256i*)ctrl);
+	return (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8((char)value)));
+}
+#endif
+
+#ifdef CONTROL_BYTES_SSE2
+inline uint32_t match_16(const unsigned char* ctrl, unsigned char value) {
+	__m128i bytes = _mm_loadu_si128((const __m128i*)ctrl);
+	return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8((char)value)));
+}
+#endif
+
+//first i in [first, last) with ctrl[i] == value, last if there is none
+inline size_t find_control(const unsigned char* ctrl, size_t first, size_t last, unsigned char value) {
+	size_t i = first;
+#ifdef CONTROL_BYTES_AVX2
+	for (; i + 32 <= last; i += 32) {
+		uint32_t mask = match_32(ctrl + i, value);
+		if (mask != 0)
+			return i + lowest_bit(mask);
+	}
+#endif
+#ifdef CONTROL_BYTES_SSE2
+	for (; i + 16 <= last; i += 16) {
+		uint32_t mask = match_16(ctrl + i, value);
+		if (mask != 0)
+			return i + lowest_bit(mask);
+	}
+#endif
+	for (; i < last; i++) {
+		if (ctrl[i] == value)
+			return i;
+	}
+	return last;
+}
+
+//first i in [first, last) with ctrl[i] != value, last if there is none
+inline size_t find_control_not(const unsigned char* ctrl, size_t first, size_t last, unsigned char value) {
+	size_t i = first;
+#ifdef CONTROL_BYTES_AVX2
+	for (; i + 32 <= last; i += 32) {
+		uint32_t mask = ~match_32(ctrl + i, value);
+		if (mask != 0)
+			return i + lowest_bit(mask);
+	}
+#endif
+#ifdef CONTROL_BYTES_SSE2
+	for (; i + 16 <= last; i += 16) {
+		uint32_t mask = ~match_16(ctrl + i, value) & 0xffff;
+		if (mask != 0)
+			return i + lowest_bit(mask);
+	}
+#endif
+	for (; i < last; i++) {
+		if (ctrl[i] != value)
+			return i;
+	}
+	return last;
+}
+
+//number of i in [first, last) with ctrl[i] == value
+inline size_t count_control(const unsigned char* ctrl, size_t first, size_t last, unsigned char value) {
+	size_t n = 0, i = first;
+#ifdef CONTROL_BYTES_AVX2
+	for (; i + 32 <= last; i += 32)
+		n += popcount32(match_32(ctrl + i, value));
+#endif
+#ifdef CONTROL_BYTES_SSE2
+	for (; i + 16 <= last; i += 16)
+		n += popcount32(match_16(ctrl + i, value));
+#endif
+	for (; i < last; i++)
+		n += ctrl[i] == value;
+	return n;
+}
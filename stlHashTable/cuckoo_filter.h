@@ -0,0 +1,313 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <vector>
+#include "aligned_allocator.h"
+#include "hash.h"
+
+
+
+//approximate set that stores 8 to 16 bit fingerprints instead of the values (Fan et al., cuckoo filter).
+//Every value has two candidate buckets of 4 fingerprint slots, the second one is computed from the
+//first and the fingerprint alone, so a fingerprint can move between its buckets without knowing its value.
+//contains() never misses an inserted value and wrongly reports a value that was never inserted
+//with the false positive rate given to the constructor. erase() may only be called for values
+//that were inserted, and a value inserted twice is stored twice (dedup stages call contains() first).
+//The buckets are packed bit arrays: at 1% the filter needs about 10.5 bits per value.
+//The packing assumes a little endian target, like the unaligned reads of hash.h
+template<	typename V,
+					typename H = default_hash<V>>
+class cuckoo_filter {
+
+	public:
+		static const size_t SLOTS = 4; //fingerprints per bucket
+		static const int MAX_KICKS = 500; //relocations before an insert gives up
+
+		//expected: number of values the filter is dimensioned for, at most 95% of the slots get used
+		//fp_rate: target false positive rate, chooses the fingerprint size between 8 and 16 bits
+		cuckoo_filter(size_t expected, double fp_rate = 0.01);
+
+		//false if the filter is full, the value is not added then. After a failed insert erase()
+		//has to make room first
+		bool insert(const V& value);
+		//false if no fingerprint of value was stored
+		bool erase(const V& value);
+		bool contains(const V& value) const;
+		void clear();
+
+		size_t size() const;
+		size_t capacity() const;
+		double load_factor() const;
+		bool empty() const;
+
+		int fingerprint_bits() const;
+		size_t memory() const;
+		double bits_per_key() const;
+		//rate predicted from the fingerprint size and the load: 2 * SLOTS * load / 2^bits
+		double expected_false_positive_rate() const;
+		//rate measured with samples random hashes, which are values that were (almost surely) never inserted
+		double measured_false_positive_rate(size_t samples = 100000) const;
+
+	private:
+		std::vector<unsigned char, huge_page_allocator<unsigned char>> table;
+		size_t n_buckets;
+		int bits;
+		uint64_t fingerprint_mask;
+		size_t count;
+		uint64_t victim; //fingerprint kicked out by the insert that filled the filter, 0 if none
+		size_t victim_bucket;
+		uint64_t random_state; //xorshift state for choosing the slots to kick out
+
+		void locate(uint64_t hash, uint64_t& fingerprint, size_t& first, size_t& second) const;
+		size_t alternate(size_t bucket, uint64_t fingerprint) const;
+		uint64_t load_bucket(size_t bucket) const;
+		void store_bucket(size_t bucket, uint64_t slots);
+		uint64_t slot(uint64_t slots, size_t i) const;
+		bool bucket_contains(size_t bucket, uint64_t fingerprint) const;
+		bool bucket_add(size_t bucket, uint64_t fingerprint);
+		bool bucket_remove(size_t bucket, uint64_t fingerprint);
+		bool contains_hash(uint64_t hash) const;
+		bool place(size_t bucket, uint64_t fingerprint);
+		uint64_t next_random();
+};
+
+//=========  PUBLIC FUNCITONS  =============
+
+template<	typename V, typename H>
+cuckoo_filter<V, H>::cuckoo_filter(size_t expected, double fp_rate) {
+	//a lookup compares 2 * SLOTS fingerprints: fp_rate ~ 2 * SLOTS / 2^bits
+	bits = (int)std::ceil(std::log2(2.0 * SLOTS / std::max(fp_rate, 1e-9)));
+	bits = std::min(std::max(bits, 8), 16);
+	fingerprint_mask = ((uint64_t)1 << bits) - 1;
+
+	//any bucket count works with alternate(), no rounding to a power of two
+	n_buckets = (size_t)std::ceil(std::max<size_t>(expected, 1) / (SLOTS * 0.95));
+	//one word of padding, buckets are read and written as unaligned 64 bit words
+	table.assign((n_buckets * SLOTS * bits + 7) / 8 + 8, 0);
+
+	count = 0;
+	victim = 0;
+	victim_bucket = 0;
+	random_state = 0x9e3779b97f4a7c15ULL;
+}
+
+template<	typename V, typename H>
+bool cuckoo_filter<V, H>::insert(const V& value) {
+	//the victim of the last full insert goes first, erases may have made room for it
+	if (victim != 0) {
+		uint64_t homeless = victim;
+		victim = 0;
+		if (!place(victim_bucket, homeless)) return false;
+	}
+
+	uint64_t fingerprint;
+	size_t first, second;
+	locate(mixed_hash<H>(value), fingerprint, first, second);
+	//the value is in even if place() fails, the fingerprint it kicked out last is the new victim
+	place(first, fingerprint);
+	count++;
+	return true;
+}
+
+template<	typename V, typename H>
+bool cuckoo_filter<V, H>::erase(const V& value) {
+	uint64_t fingerprint;
+	size_t first, second;
+	locate(mixed_hash<H>(value), fingerprint, first, second);
+	if (bucket_remove(first, fingerprint) || bucket_remove(second, fingerprint)) {
+		count--;
+		return true;
+	}
+	if (victim == fingerprint && (victim_bucket == first || victim_bucket == second)) {
+		victim = 0;
+		count--;
+		return true;
+	}
+	return false;
+}
+
+template<	typename V, typename H>
+bool cuckoo_filter<V, H>::contains(const V& value) const {
+	return contains_hash(mixed_hash<H>(value));
+}
+
+template<	typename V, typename H>
+void cuckoo_filter<V, H>::clear() {
+	std::fill(table.begin(), table.end(), 0);
+	count = 0;
+	victim = 0;
+}
+
+template<typename V, typename H>
+size_t cuckoo_filter<V, H>::size() const {
+	return count;
+}
+
+template<typename V, typename H>
+size_t cuckoo_filter<V, H>::capacity() const {
+	return n_buckets * SLOTS;
+}
+
+template<typename V, typename H>
+double cuckoo_filter<V, H>::load_factor() const {
+	return (double)count / capacity();
+}
+
+template<typename V, typename H>
+bool cuckoo_filter<V, H>::empty() const {
+	return count == 0;
+}
+
+template<typename V, typename H>
+int cuckoo_filter<V, H>::fingerprint_bits() const {
+	return bits;
+}
+
+template<typename V, typename H>
+size_t cuckoo_filter<V, H>::memory() const {
+	return table.size();
+}
+
+template<typename V, typename H>
+double cuckoo_filter<V, H>::bits_per_key() const {
+	return count == 0 ? 0 : memory() * 8.0 / count;
+}
+
+template<typename V, typename H>
+double cuckoo_filter<V, H>::expected_false_positive_rate() const {
+	return std::min(1.0, 2.0 * SLOTS * load_factor() / ((double)fingerprint_mask + 1));
+}
+
+template<typename V, typename H>
+double cuckoo_filter<V, H>::measured_false_positive_rate(size_t samples) const {
+	if (samples == 0) return 0;
+	size_t positives = 0;
+	for (uint64_t i = 1; i <= samples; i++)
+		positives += contains_hash(mix64(i * 0xd6e8feb86659fd93ULL));
+	return (double)positives / samples;
+}
+
+//=========  PRIVATE FUNCITONS  =============
+
+//the low bits of the hash pick the first bucket, the high bits the fingerprint. 0 marks a free slot,
+//so fingerprints are never 0
+template<typename V, typename H>
+void cuckoo_filter<V, H>::locate(uint64_t hash, uint64_t& fingerprint, size_t& first, size_t& second) const {
+	fingerprint = (hash >> 32) & fingerprint_mask;
+	if (fingerprint == 0)
+		fingerprint = 1;
+	first = (size_t)(hash % n_buckets);
+	second = alternate(first, fingerprint);
+}
+
+//h(f) - b modulo the bucket count: alternate(alternate(b, f), f) == b. The usual XOR needs a power
+//of two bucket count, which wastes up to half of the memory
+template<typename V, typename H>
+size_t cuckoo_filter<V, H>::alternate(size_t bucket, uint64_t fingerprint) const {
+	size_t h = (size_t)(mix64(fingerprint) % n_buckets);
+	return bucket <= h ? h - bucket : h + n_buckets - bucket;
+}
+
+//the SLOTS fingerprints of a bucket, slot i in bits [i * bits, (i + 1) * bits)
+template<typename V, typename H>
+uint64_t cuckoo_filter<V, H>::load_bucket(size_t bucket) const {
+	size_t bit = bucket * SLOTS * bits;
+	uint64_t word;
+	std::memcpy(&word, &table[bit / 8], sizeof(word));
+	word >>= bit % 8;
+	return SLOTS * bits == 64 ? word : word & (((uint64_t)1 << (SLOTS * bits)) - 1);
+}
+
+template<typename V, typename H>
+void cuckoo_filter<V, H>::store_bucket(size_t bucket, uint64_t slots) {
+	size_t bit = bucket * SLOTS * bits;
+	uint64_t word;
+	std::memcpy(&word, &table[bit / 8], sizeof(word));
+	uint64_t mask = SLOTS * bits == 64 ? ~(uint64_t)0 : ((uint64_t)1 << (SLOTS * bits)) - 1;
+	word = (word & ~(mask << (bit % 8))) | (slots << (bit % 8));
+	std::memcpy(&table[bit / 8], &word, sizeof(word));
+}
+
+template<typename V, typename H>
+uint64_t cuckoo_filter<V, H>::slot(uint64_t slots, size_t i) const {
+	return (slots >> (i * bits)) & fingerprint_mask;
+}
+
+template<typename V, typename H>
+bool cuckoo_filter<V, H>::bucket_contains(size_t bucket, uint64_t fingerprint) const {
+	uint64_t slots = load_bucket(bucket);
+	for (size_t i = 0; i < SLOTS; i++) {
+		if (slot(slots, i) == fingerprint) return true;
+	}
+	return false;
+}
+
+template<typename V, typename H>
+bool cuckoo_filter<V, H>::bucket_add(size_t bucket, uint64_t fingerprint) {
+	uint64_t slots = load_bucket(bucket);
+	for (size_t i = 0; i < SLOTS; i++) {
+		if (slot(slots, i) == 0) {
+			store_bucket(bucket, slots | (fingerprint << (i * bits)));
+			return true;
+		}
+	}
+	return false;
+}
+
+template<typename V, typename H>
+bool cuckoo_filter<V, H>::bucket_remove(size_t bucket, uint64_t fingerprint) {
+	uint64_t slots = load_bucket(bucket);
+	for (size_t i = 0; i < SLOTS; i++) {
+		if (slot(slots, i) == fingerprint) {
+			store_bucket(bucket, slots & ~(fingerprint_mask << (i * bits)));
+			return true;
+		}
+	}
+	return false;
+}
+
+template<typename V, typename H>
+bool cuckoo_filter<V, H>::contains_hash(uint64_t hash) const {
+	uint64_t fingerprint;
+	size_t first, second;
+	locate(hash, fingerprint, first, second);
+	if (victim == fingerprint && (victim_bucket == first || victim_bucket == second))
+		return true;
+	return bucket_contains(first, fingerprint) || bucket_contains(second, fingerprint);
+}
+
+//stores fingerprint in bucket or its alternate. If both are full a random fingerprint is kicked to its
+//other bucket until one finds a free slot. After MAX_KICKS the last kicked one becomes the victim
+template<typename V, typename H>
+bool cuckoo_filter<V, H>::place(size_t bucket, uint64_t fingerprint) {
+	if (bucket_add(bucket, fingerprint)) return true;
+	bucket = alternate(bucket, fingerprint);
+	if (bucket_add(bucket, fingerprint)) return true;
+
+	if (next_random() & 1)
+		bucket = alternate(bucket, fingerprint);
+	for (int kick = 0; kick < MAX_KICKS; kick++) {
+		size_t i = next_random() % SLOTS;
+		uint64_t slots = load_bucket(bucket);
+		uint64_t kicked = slot(slots, i);
+		slots &= ~(fingerprint_mask << (i * bits));
+		store_bucket(bucket, slots | (fingerprint << (i * bits)));
+		fingerprint = kicked;
+		bucket = alternate(bucket, fingerprint);
+		if (bucket_add(bucket, fingerprint)) return true;
+	}
+	victim = fingerprint;
+	victim_bucket = bucket;
+	return false;
+}
+
+template<typename V, typename H>
+uint64_t cuckoo_filter<V, H>::next_random() {
+	random_state ^= random_state << 13;
+	random_state ^= random_state >> 7;
+	random_state ^= random_state << 17;
+	return random_state;
+}
@@ -0,0 +1,134 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include "hash.h"
+
+
+
+//values siphash can read from their bytes because equal values have equal bytes
+template<typename V, typename Enable = void>
+struct byte_key {
+	static const bool available = false;
+};
+
+template<typename V>
+struct byte_key<V, typename std::enable_if<std::is_integral<V>::value || std::is_enum<V>::value>::type> {
+	static const bool available = true;
+	static uint64_t hash(const V& value, uint64_t k0, uint64_t k1) {
+		return siphash(&value, sizeof(V), k0, k1);
+	}
+};
+
+template<>
+struct byte_key<std::string> {
+	static const bool available = true;
+	static uint64_t hash(const std::string& value, uint64_t k0, uint64_t k1) {
+		return siphash(value.data(), value.size(), k0, k1);
+	}
+};
+
+template<>
+struct byte_key<std::string_view> {
+	static const bool available = true;
+	static uint64_t hash(std::string_view value, uint64_t k0, uint64_t k1) {
+		return siphash(value.data(), value.size(), k0, k1);
+	}
+};
+
+//hash function of one table, hardened against collision flooding.
+//A table starts in plain mode and calls H unchanged, so trusted data pays one predictable branch.
+//When the table sees a chain or probe run that a working hash function practically never
+//produces, it escalates and rehashes:
+//plain -> seeded: mix64(H()(value) ^ random seed), defeats keys that only collide modulo the capacity
+//seeded -> keyed: SipHash of the value bytes with a random key, defeats keys with equal H() results.
+//Keyed mode needs integers, enums or strings compared with std::equal_to, other types stay seeded
+template<typename V, typename H, typename C>
+class flood_guard {
+
+	public:
+		enum mode_type { plain, seeded, keyed };
+
+		//longest chain of a separate chaining table that is accepted without escalation.
+		//Random hashing at load factor 0.75 stays below 12 for a billion values
+		static const size_t MAX_CHAIN = 32;
+
+		flood_guard() : mode(plain), k0(0), k1(0) {}
+
+		size_t operator()(const V& value) const {
+			if (mode == plain)
+				return H()(value);
+			return hash_slow(value);
+		}
+
+		mode_type get_mode() const {
+			return mode;
+		}
+
+		bool can_escalate() const {
+			return mode == plain || (mode == seeded && keyed_available);
+		}
+
+		bool chain_too_long(size_t length) const {
+			return length > MAX_CHAIN && can_escalate();
+		}
+
+		//linear probing has longer runs than chains, they grow with log(capacity).
+		//probes counts the values compared, deleted slots are not the hash function's fault
+		bool probe_too_long(size_t probes, size_t capacity) const {
+			if (probes <= 64 || !can_escalate()) return false;
+			return probes > probe_limit(capacity);
+		}
+
+		static size_t probe_limit(size_t capacity) {
+			size_t limit = 64;
+			for (size_t c = capacity; c > 1; c >>= 1)
+				limit += 16;
+			return limit;
+		}
+
+		//switches to the next mode with fresh random keys. The table has to rehash afterwards
+		void escalate() {
+			if (mode == plain)
+				mode = seeded;
+			else if (mode == seeded && keyed_available)
+				mode = keyed;
+			k0 = random_seed();
+			k1 = random_seed();
+		}
+
+		//new random keys without waiting for an attack, at least seeded mode.
+		//The table has to rehash afterwards
+		void reseed() {
+			if (mode == plain)
+				mode = seeded;
+			k0 = random_seed();
+			k1 = random_seed();
+		}
+
+		//tables with equal guards store a value in the same bucket of equal capacities
+		bool operator==(const flood_guard& other) const {
+			return mode == other.mode && k0 == other.k0 && k1 == other.k1;
+		}
+
+		bool operator!=(const flood_guard& other) const {
+			return !(*this == other);
+		}
+
+	private:
+		static const bool keyed_available = byte_key<V>::available && std::is_same<C, std::equal_to<V>>::value;
+
+		mode_type mode;
+		uint64_t k0;
+		uint64_t k1;
+
+		size_t hash_slow(const V& value) const {
+			if constexpr (keyed_available) {
+				if (mode == keyed)
+					return (size_t)byte_key<V>::hash(value, k0, k1);
+			}
+			return (size_t)mix64(H()(value) ^ k0);
+		}
+};
@@ -0,0 +1,229 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+//64 bit finalizer (MurmurHash3 fmix64). Spreads every input bit over the whole output,
+//so the low bits used for bucket indices depend on all bits of the hash
+inline uint64_t mix64(uint64_t h) {
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+	return h;
+}
+
+//full 128 bit product of a and b
+inline void mul128(uint64_t a, uint64_t b, uint64_t& lo, uint64_t& hi) {
+#if defined(__SIZEOF_INT128__)
+	__uint128_t r = (__uint128_t)a * b;
+	lo = (uint64_t)r;
+	hi = (uint64_t)(r >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+	lo = _umul128(a, b, &hi);
+#else
+	uint64_t a_lo = (uint32_t)a, a_hi = a >> 32;
+	uint64_t b_lo = (uint32_t)b, b_hi = b >> 32;
+	uint64_t lo_lo = a_lo * b_lo, hi_lo = a_hi * b_lo;
+	uint64_t lo_hi = a_lo * b_hi, hi_hi = a_hi * b_hi;
+	uint64_t cross = (lo_lo >> 32) + (uint32_t)hi_lo + lo_hi;
+	lo = (cross << 32) | (uint32_t)lo_lo;
+	hi = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+#endif
+}
+
+//multiplies and folds the 128 bit product, the core mixing step of hash_bytes
+inline uint64_t mul_fold(uint64_t a, uint64_t b) {
+	uint64_t lo, hi;
+	mul128(a, b, lo, hi);
+	return lo ^ hi;
+}
+
+inline uint64_t read64(const unsigned char* p) {
+	uint64_t v;
+	std::memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+inline uint64_t read32(const unsigned char* p) {
+	uint32_t v;
+	std::memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+//byte hash in the style of wyhash: 16 bytes per multiply, 48 bytes per round for long inputs,
+//overlapping reads instead of a byte loop for the tail
+inline uint64_t hash_bytes(const void* key, size_t len, uint64_t seed = 0) {
+	const uint64_t P0 = 0xa0761d6478bd642fULL;
+	const uint64_t P1 = 0xe7037ed1a0b428dbULL;
+	const uint64_t P2 = 0x8ebc6af09c88c6e3ULL;
+	const uint64_t P3 = 0x589965cc75374cc3ULL;
+
+	const unsigned char* p = static_cast<const unsigned char*>(key);
+	seed ^= mul_fold(seed ^ P0, P1);
+	uint64_t a, b;
+
+	if (len <= 16) {
+		if (len >= 4) {
+			size_t shift = (len >> 3) << 2;
+			a = (read32(p) << 32) | read32(p + shift);
+			b = (read32(p + len - 4) << 32) | read32(p + len - 4 - shift);
+		} else if (len > 0) {
+			a = ((uint64_t)p[0] << 16) | ((uint64_t)p[len >> 1] << 8) | p[len - 1];
+			b = 0;
+		} else {
+			a = 0;
+			b = 0;
+		}
+	} else {
+		size_t i = len;
+		if (i > 48) {
+			uint64_t seed1 = seed, seed2 = seed;
+			do {
+				seed = mul_fold(read64(p) ^ P1, read64(p + 8) ^ seed);
+				seed1 = mul_fold(read64(p + 16) ^ P2, read64(p + 24) ^ seed1);
+				seed2 = mul_fold(read64(p + 32) ^ P3, read64(p + 40) ^ seed2);
+				p += 48;
+				i -= 48;
+			} while (i > 48);
+			seed ^= seed1 ^ seed2;
+		}
+		while (i > 16) {
+			seed = mul_fold(read64(p) ^ P1, read64(p + 8) ^ seed);
+			p += 16;
+			i -= 16;
+		}
+		a = read64(p + i - 16);
+		b = read64(p + i - 8);
+	}
+
+	uint64_t lo, hi;
+	mul128(a ^ P1, b ^ seed, lo, hi);
+	return mul_fold(lo ^ P0 ^ len, hi ^ P1);
+}
+
+#define SIPROUND(v0, v1, v2, v3) \
+	v0 += v1; v1 = (v1 << 13) | (v1 >> 51); v1 ^= v0; v0 = (v0 << 32) | (v0 >> 32); \
+	v2 += v3; v3 = (v3 << 16) | (v3 >> 48); v3 ^= v2; \
+	v0 += v3; v3 = (v3 << 21) | (v3 >> 43); v3 ^= v0; \
+	v2 += v1; v1 = (v1 << 17) | (v1 >> 47); v1 ^= v2; v2 = (v2 << 32) | (v2 >> 32)
+
+//SipHash-2-4 keyed with k0, k1. Much slower than hash_bytes, but without the key
+//nobody can compute inputs that collide
+inline uint64_t siphash(const void* key, size_t len, uint64_t k0, uint64_t k1) {
+	uint64_t v0 = 0x736f6d6570736575ULL ^ k0;
+	uint64_t v1 = 0x646f72616e646f6dULL ^ k1;
+	uint64_t v2 = 0x6c7967656e657261ULL ^ k0;
+	uint64_t v3 = 0x7465646279746573ULL ^ k1;
+
+	const unsigned char* p = static_cast<const unsigned char*>(key);
+	const unsigned char* end = p + (len & ~(size_t)7);
+	for (; p != end; p += 8) {
+		uint64_t m = read64(p);
+		v3 ^= m;
+		SIPROUND(v0, v1, v2, v3);
+		SIPROUND(v0, v1, v2, v3);
+		v0 ^= m;
+	}
+
+	uint64_t last = (uint64_t)len << 56;
+	for (size_t i = 0; i < (len & 7); i++)
+		last |= (uint64_t)p[i] << (8 * i);
+	v3 ^= last;
+	SIPROUND(v0, v1, v2, v3);
+	SIPROUND(v0, v1, v2, v3);
+	v0 ^= last;
+
+	v2 ^= 0xff;
+	for (int i = 0; i < 4; i++) {
+		SIPROUND(v0, v1, v2, v3);
+	}
+	return v0 ^ v1 ^ v2 ^ v3;
+}
+
+#undef SIPROUND
+
+//unpredictable 64 bit value for hash seeds. Calls std::random_device, so it is meant
+//for the rare reseed of a table, not for every construction
+inline uint64_t random_seed() {
+	std::random_device device;
+	uint64_t seed = ((uint64_t)device() << 32) ^ device();
+	return mix64(seed ^ (uint64_t)std::chrono::steady_clock::now().time_since_epoch().count());
+}
+
+//combines the hash of one more component into seed, for composite keys
+inline uint64_t hash_combine(uint64_t seed, uint64_t hash) {
+	return mix64(seed ^ (hash + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2)));
+}
+
+//default hash functor of all tables.
+//integers and enums are mixed with mix64, strings and types without padding are hashed
+//bytewise with hash_bytes, everything else uses std::hash followed by mix64
+template<typename T, typename Enable = void>
+struct default_hash {
+	size_t operator()(const T& value) const {
+		return (size_t)mix64(std::hash<T>()(value));
+	}
+};
+
+template<typename T>
+struct default_hash<T, typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type> {
+	size_t operator()(const T& value) const {
+		return (size_t)mix64((uint64_t)value);
+	}
+};
+
+template<typename T>
+struct default_hash<T, typename std::enable_if<!std::is_integral<T>::value && !std::is_enum<T>::value &&
+	std::has_unique_object_representations<T>::value>::type> {
+	size_t operator()(const T& value) const {
+		return (size_t)hash_bytes(&value, sizeof(T));
+	}
+};
+
+template<>
+struct default_hash<std::string> {
+	size_t operator()(const std::string& value) const {
+		return (size_t)hash_bytes(value.data(), value.size());
+	}
+};
+
+template<>
+struct default_hash<std::string_view> {
+	size_t operator()(std::string_view value) const {
+		return (size_t)hash_bytes(value.data(), value.size());
+	}
+};
+
+template<typename H>
+struct is_default_hash : std::false_type {};
+
+template<typename T, typename Enable>
+struct is_default_hash<default_hash<T, Enable>> : std::true_type {};
+
+//hash for tables that take their indices and tags straight from the bits of H(). default_hash is
+//mixed already, other functors are finalized with mix64, e.g. std::hash is the identity for integers
+template<typename H, typename T>
+uint64_t mixed_hash(const T& value) {
+	if constexpr (is_default_hash<H>::value)
+		return (uint64_t)H()(value);
+	else
+		return mix64(H()(value));
+}
+
+//hash of a composite key, e.g. hash_values(id, name) for a struct { int id; std::string name; }
+template<typename... Ts>
+uint64_t hash_values(const Ts&... values) {
+	uint64_t seed = 0;
+	((seed = hash_combine(seed, default_hash<Ts>()(values))), ...);
+	return seed;
+}
@@ -7,7 +7,7 @@ public:
 
   virtual void insert(const V& value) = 0;
   virtual void erase(const V& value) = 0;
-  virtual bool contains(const V& value) = 0;
+  virtual bool contains(const V& value) const = 0;
   virtual void rehash(size_t new_n_buckets) = 0;
   virtual void clear() = 0;
 
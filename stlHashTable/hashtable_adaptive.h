@@ -0,0 +1,385 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <ostream>
+#include "hash.h"
+#include "hashtable.h"
+#include "hashtable_oa.h"
+#include "hashtable_sc.h"
+#include "parallel.h"
+
+
+
+enum adaptive_layout {
+	chaining_layout,
+	open_addressing_layout
+};
+
+//set that picks its own layout. It counts its reads, hits, inserts and erases, and when the next insert
+//would grow the table, or on rehash(), a cost model compares chaining and open addressing for
+//that mix at the new capacity. If the other layout is clearly cheaper the values are moved into it,
+//in place of the rehash that was due anyway. The model counts cache lines touched per operation:
+//a chain costs a line per node and an allocation per insert, open addressing a line per
+//64 bytes of probed slots and a tombstone per erase, which lengthens later probes
+template<	typename V,
+					typename H = default_hash<V>,
+					typename C = std::equal_to<V>>
+class hashtable_adaptive : hashtable<V, H, C> {
+
+	public:
+		typedef hashtable_sc<V, H, C> chaining_table;
+		typedef hashtable_oa<V, H, C> open_addressing_table;
+
+		//the layout is chosen after MIN_SAMPLES operations, and only changed for a MIN_GAIN lower cost
+		static const size_t MIN_SAMPLES = 1000;
+		static constexpr double MIN_GAIN = 0.8;
+
+		hashtable_adaptive(size_t capacity, adaptive_layout initial = open_addressing_layout);
+		hashtable_adaptive(const hashtable_adaptive& other);
+		hashtable_adaptive& operator=(const hashtable_adaptive& other);
+
+		~hashtable_adaptive() {}
+		void insert(const V& value)override;
+		void erase(const V& value)override;
+		bool contains(const V& value) const override;
+		void rehash(size_t new_n_buckets)override;
+		void clear()override;
+
+		double load_factor() const override;
+		size_t size() const override;
+		size_t capacity() const override;
+		bool empty() const override;
+
+		adaptive_layout layout() const;
+		size_t migrations() const;
+		//cache lines per operation the model expects from layout for the operations counted since
+		//the last decision, at the given capacity
+		double estimated_cost(adaptive_layout layout, size_t capacity) const;
+
+		//calls fn(value) for every value, with par(n) concurrently
+		template<typename F>
+		void for_each(execution_policy policy, F fn) const;
+
+		friend std::ostream& operator<<(std::ostream& os, const hashtable_adaptive<V, H, C>& ht) {
+			if (ht.active == chaining_layout)
+				return os << ht.chains;
+			return os << ht.slots;
+		}
+
+		class const_iterator;
+
+		const_iterator begin() const {
+			return const_iterator(active, chains.begin(), slots.begin());
+		}
+
+		const_iterator end() const {
+			return const_iterator(active, chains.end(), slots.end());
+		}
+
+		using iterator_category = std::bidirectional_iterator_tag;
+		using value_type = V const;
+		using difference_type = std::ptrdiff_t;
+		using const_pointer = V const*;
+		using const_reference = V const&;
+
+		typedef std::iterator<std::bidirectional_iterator_tag, value_type, difference_type, const_pointer,
+			const_reference> iterator_base;
+
+	private:
+		chaining_table chains; //capacity 1 while inactive
+		open_addressing_table slots; //capacity 1 while inactive
+		adaptive_layout active;
+		size_t migrated;
+		//counted by contains(), which concurrent readers may call
+		mutable std::atomic<size_t> reads;
+		mutable std::atomic<size_t> hits;
+		size_t inserts;
+		size_t erases;
+
+		static const size_t CACHE_LINE = 64;
+		static constexpr double ALLOCATION = 2; //cost of a node allocation or free in cache lines
+
+		void decide(size_t new_capacity);
+		void migrate(size_t new_capacity);
+};
+
+//=========  PUBLIC FUNCITONS  =============
+
+template<	typename V, typename H, typename C>
+hashtable_adaptive<V, H, C>::hashtable_adaptive(size_t capacity, adaptive_layout initial)
+	: chains(initial == chaining_layout ? capacity : 1), slots(initial == open_addressing_layout ? capacity : 1) {
+	active = initial;
+	migrated = 0;
+	reads = 0;
+	hits = 0;
+	inserts = 0;
+	erases = 0;
+}
+
+template<	typename V, typename H, typename C>
+hashtable_adaptive<V, H, C>::hashtable_adaptive(const hashtable_adaptive& other)
+	: chains(other.chains), slots(other.slots) {
+	active = other.active;
+	migrated = other.migrated;
+	reads = other.reads.load(std::memory_order_relaxed);
+	hits = other.hits.load(std::memory_order_relaxed);
+	inserts = other.inserts;
+	erases = other.erases;
+}
+
+template<	typename V, typename H, typename C>
+hashtable_adaptive<V, H, C>& hashtable_adaptive<V, H, C>::operator=(const hashtable_adaptive& other) {
+	chains = other.chains;
+	slots = other.slots;
+	active = other.active;
+	migrated = other.migrated;
+	reads = other.reads.load(std::memory_order_relaxed);
+	hits = other.hits.load(std::memory_order_relaxed);
+	inserts = other.inserts;
+	erases = other.erases;
+	return *this;
+}
+
+template<	typename V, typename H, typename C>
+void hashtable_adaptive<V, H, C>::insert(const V& value) {
+	inserts++;
+	//both tables grow beyond a load factor of 0.75, this is the rehash the layout can change at
+	if ((double)(size() + 1) / capacity() > 0.75)
+		decide(capacity() * 2);
+	if (active == chaining_layout)
+		chains.insert(value);
+	else
+		slots.insert(value);
+}
+
+template<	typename V, typename H, typename C>
+void hashtable_adaptive<V, H, C>::erase(const V& value) {
+	erases++;
+	if (active == chaining_layout)
+		chains.erase(value);
+	else
+		slots.erase(value);
+}
+
+template<	typename V, typename H, typename C>
+bool hashtable_adaptive<V, H, C>::contains(const V& value) const {
+	reads.fetch_add(1, std::memory_order_relaxed);
+	bool found = active == chaining_layout ? chains.contains(value) : slots.contains(value);
+	if (found)
+		hits.fetch_add(1, std::memory_order_relaxed);
+	return found;
+}
+
+template<	typename V, typename H, typename C>
+void hashtable_adaptive<V, H, C>::rehash(size_t new_n_buckets) {
+	new_n_buckets = std::max<size_t>(new_n_buckets, 1);
+	decide(new_n_buckets);
+	if (active == chaining_layout)
+		chains.rehash(new_n_buckets);
+	else
+		slots.rehash(new_n_buckets);
+}
+
+template<	typename V, typename H, typename C>
+void hashtable_adaptive<V, H, C>::clear() {
+	chains.clear();
+	slots.clear();
+}
+
+template<typename V, typename H, typename C>
+double hashtable_adaptive<V, H, C>::load_factor() const {
+	return (double)size() / capacity();
+}
+
+template<typename V, typename H, typename C>
+size_t hashtable_adaptive<V, H, C>::size() const {
+	return active == chaining_layout ? chains.size() : slots.size();
+}
+
+template<typename V, typename H, typename C>
+size_t hashtable_adaptive<V, H, C>::capacity() const {
+	return active == chaining_layout ? chains.capacity() : slots.capacity();
+}
+
+template<typename V, typename H, typename C>
+bool hashtable_adaptive<V, H, C>::empty() const {
+	return size() == 0;
+}
+
+template<typename V, typename H, typename C>
+adaptive_layout hashtable_adaptive<V, H, C>::layout() const {
+	return active;
+}
+
+template<typename V, typename H, typename C>
+size_t hashtable_adaptive<V, H, C>::migrations() const {
+	return migrated;
+}
+
+template<typename V, typename H, typename C>
+double hashtable_adaptive<V, H, C>::estimated_cost(adaptive_layout layout, size_t capacity) const {
+	size_t read_count = reads.load(std::memory_order_relaxed);
+	size_t hit_count = hits.load(std::memory_order_relaxed);
+	size_t operations = read_count + inserts + erases;
+	if (operations == 0) return 0;
+	double load = std::min((double)(size() + 1) / capacity, 0.95);
+	double hit_share = read_count == 0 ? 0.5 : (double)hit_count / read_count;
+
+	//the measured probe lengths of the active table against the model at its current load: clustering
+	//from a weak hash makes the active layout look as bad as it is
+	if (layout == chaining_layout) {
+		//the bucket, then one line per node: hit 1 + a/2, miss a nodes
+		double skew = 1;
+		if (active == chaining_layout && !chains.empty())
+			skew = chains.mean_probe_length() / (1 + chains.load_factor() / 2);
+		double hit = 1 + skew * (1 + load / 2);
+		double miss = 1 + skew * load;
+		double read = hit_share * hit + (1 - hit_share) * miss;
+		return (read_count * read + inserts * (miss + ALLOCATION) + erases * (hit + ALLOCATION)) / operations;
+	}
+
+	//linear probing (Knuth): hit 1/2 (1 + 1/(1 - a)), miss 1/2 (1 + 1/(1 - a)^2) slots. Tombstones stay in
+	//the probe sequences until the next rehash and count as load, an erase share e leaves about e * load
+	//of the slots deleted. Slots after the first one are read sequentially, a line holds 64 bytes of them
+	double tombstones = (double)erases / operations * load;
+	double skew = 1;
+	if (active == open_addressing_layout && !slots.empty()) {
+		double deleted = (double)slots.deleted_slots() / slots.capacity();
+		double current = std::min(slots.load_factor() + deleted, 0.95);
+		skew = slots.mean_probe_length() / ((1 + 1 / (1 - current)) / 2);
+		tombstones = std::max(tombstones, deleted);
+	}
+	double full = std::min(load + tombstones, 0.95);
+	double hit_slots = skew * (1 + 1 / (1 - full)) / 2;
+	double miss_slots = skew * (1 + 1 / ((1 - full) * (1 - full))) / 2;
+	size_t alignment = line_alignment(sizeof(V) + 1, alignof(V));
+	double slot_lines = (double)((sizeof(V) + alignment) / alignment * alignment) / CACHE_LINE;
+	double hit = 1 + (hit_slots - 1) * slot_lines;
+	double miss = 1 + (miss_slots - 1) * slot_lines;
+	double read = hit_share * hit + (1 - hit_share) * miss;
+	//every value is moved at each doubling, about once per insert
+	return (read_count * read + inserts * (miss + slot_lines) + erases * hit) / operations;
+}
+
+template<typename V, typename H, typename C>
+template<typename F>
+void hashtable_adaptive<V, H, C>::for_each(execution_policy policy, F fn) const {
+	if (active == chaining_layout)
+		chains.for_each(policy, fn);
+	else
+		slots.for_each(policy, fn);
+}
+
+//=========  PRIVATE FUNCITONS  =============
+
+//runs the cost model for the table at new_capacity and migrates if the other layout wins.
+//The counters start over either way, so the next decision sees the recent mix
+template<typename V, typename H, typename C>
+void hashtable_adaptive<V, H, C>::decide(size_t new_capacity) {
+	if (reads.load(std::memory_order_relaxed) + inserts + erases < MIN_SAMPLES) return;
+	adaptive_layout other = active == chaining_layout ? open_addressing_layout : chaining_layout;
+	if (estimated_cost(other, new_capacity) < MIN_GAIN * estimated_cost(active, new_capacity))
+		migrate(new_capacity);
+	reads = 0;
+	hits = 0;
+	inserts = 0;
+	erases = 0;
+}
+
+//moves the values into the other layout with new_capacity, the old table shrinks to capacity 1
+template<typename V, typename H, typename C>
+void hashtable_adaptive<V, H, C>::migrate(size_t new_capacity) {
+	if (active == chaining_layout) {
+		slots = open_addressing_table(new_capacity);
+		for (const V& value : chains)
+			slots.insert(value);
+		chains = chaining_table(1);
+		active = open_addressing_layout;
+	} else {
+		chains = chaining_table(new_capacity);
+		for (const V& value : slots)
+			chains.insert(value);
+		slots = open_addressing_table(1);
+		active = chaining_layout;
+	}
+	migrated++;
+}
+
+//==========  DEFINITION OF ITERATOR CLASS ==============
+
+
+//holds an iterator of both tables and moves the one of the active layout. A migration invalidates it
+template<typename V, typename H, typename C>
+class hashtable_adaptive<V, H, C>::const_iterator : public iterator_base {
+
+	private:
+		typedef typename chaining_table::const_iterator chaining_iterator;
+		typedef typename open_addressing_table::const_iterator open_addressing_iterator;
+
+		adaptive_layout layout;
+		chaining_iterator chain_iterator;
+		open_addressing_iterator slot_iterator;
+
+	public:
+
+		const_iterator(adaptive_layout layout, chaining_iterator chain_iterator, open_addressing_iterator slot_iterator)
+			: layout(layout), chain_iterator(chain_iterator), slot_iterator(slot_iterator) {}
+
+		bool operator==(const_iterator const& rhs) const {
+			if (layout != rhs.layout) return false;
+			return layout == chaining_layout ? chain_iterator == rhs.chain_iterator : slot_iterator == rhs.slot_iterator;
+		}
+
+		bool operator!=(const_iterator const& rhs) const {
+			return !(*this == rhs);
+		}
+
+		const_reference operator*() const {
+			return layout == chaining_layout ? *chain_iterator : *slot_iterator;
+		}
+
+		const_pointer operator->() const {
+			return &(**this);
+		}
+
+		const_iterator& operator++() {
+			if (layout == chaining_layout)
+				++chain_iterator;
+			else
+				++slot_iterator;
+			return *this;
+		}
+
+		const_iterator& operator--() {
+			if (layout == chaining_layout)
+				--chain_iterator;
+			else
+				--slot_iterator;
+			return *this;
+		}
+
+		const_iterator operator++(int) {
+			const_iterator temp = *this; // Preserve state because of post-increment
+			++(*this);
+			return temp;
+		}
+
+		const_iterator operator--(int) {
+			const_iterator temp = *this; //preserve state because post increment
+			--(*this);
+			return temp;
+		}
+};
+
+template<typename V, typename H, typename C>
+bool operator==(const hashtable_adaptive<V, H, C>& lhs, const hashtable_adaptive<V, H, C>& rhs) {
+	if (lhs.size() != rhs.size()) return false;
+
+	for (const V& item : lhs) {
+		if (!rhs.contains(item)) return false;
+	}
+	return true;
+}
@@ -0,0 +1,546 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <ostream>
+#include <vector>
+#include "aligned_allocator.h"
+#include "flood_guard.h"
+#include "hash.h"
+#include "hashtable.h"
+
+
+
+//bucketized cuckoo hashing: every value lives in one of two candidate buckets with 4 slots each,
+//so a lookup reads at most two buckets regardless of the load factor.
+//Inserts move values along the shortest eviction path (bounded BFS), values without a path
+//go to a stash of at most STASH_SIZE values. A full stash grows the table, or below half load,
+//where the hash function is at fault, switches to a new seeded or keyed hash (see flood_guard.h)
+template<	typename V,
+					typename H = default_hash<V>,
+					typename C = std::equal_to<V>>
+class hashtable_cuckoo : hashtable<V, H, C> {
+
+	public:
+
+		static const size_t SLOTS = 4;
+		static const size_t STASH_SIZE = 8;
+		static const size_t MAX_BFS_NODES = 512;
+		//new hashes tried at one capacity before the stash takes values no hash separates
+		static const size_t MAX_RESEEDS = 4;
+
+		hashtable_cuckoo(size_t capacity) {
+			n_buckets = bucket_count_for(capacity);
+			data = bucket_vector(n_buckets);
+			count = 0;
+			reseeds = 0;
+		}
+
+		~hashtable_cuckoo() {}
+		void insert(const V& value)override;
+		void erase(const V& value)override;
+		bool contains(const V& value) const override;
+		void rehash(size_t new_n_buckets)override;
+		void clear()override;
+
+		double load_factor() const override;
+		size_t size() const override;
+		size_t capacity() const override;
+		bool empty() const override;
+
+		size_t stash_size() const;
+		typename flood_guard<V, H, C>::mode_type hash_mode() const;
+
+		friend std::ostream& operator<<(std::ostream& os, const hashtable_cuckoo<V, H, C>& ht) {
+			for (const Bucket& bucket : ht.data) {
+				for (size_t i = 0; i < SLOTS; i++) {
+					if (bucket.tags[i] != 0)
+						os << bucket.values[i] << " ";
+				}
+			}
+			for (const V& item : ht.stash)
+				os << item << " ";
+			os << "\n";
+			return os;
+		}
+
+		class const_iterator;
+
+		const_iterator begin() const {
+			return const_iterator(this, 0);
+		}
+
+		const_iterator end() const {
+			return const_iterator(this, n_buckets * SLOTS + stash.size());
+		}
+
+		using iterator_category = std::bidirectional_iterator_tag;
+		using value_type = V const;
+		using difference_type = std::ptrdiff_t;
+		using const_pointer = V const*;
+		using const_reference = V const&;
+
+		typedef std::iterator<std::bidirectional_iterator_tag, value_type, difference_type, const_pointer,
+			const_reference> iterator_base;
+
+		//tag = 0 -> slot is empty
+		//tag > 0 -> slot is occupied, the tag is an 8 bit fingerprint of the hash
+		//buckets up to 64 bytes are aligned to their power of two size and never straddle a cache line
+		struct alignas(line_alignment(SLOTS + SLOTS * sizeof(V), alignof(V))) Bucket {
+			uint8_t tags[SLOTS];
+			V values[SLOTS];
+		};
+
+	private:
+		typedef std::vector<Bucket, huge_page_allocator<Bucket>> bucket_vector;
+
+		//one step of an eviction path: the value in slot of bucket moves to its other bucket
+		struct bfs_node {
+			size_t bucket;
+			size_t slot;
+			int parent;
+		};
+
+		bucket_vector data;
+		std::vector<V> stash;
+		size_t count;
+		size_t n_buckets; //always a power of two
+		flood_guard<V, H, C> guard;
+		size_t reseeds; //new hashes since the capacity last changed
+
+		static size_t bucket_count_for(size_t capacity);
+		uint64_t get_hash(const V& value) const;
+		size_t primary_bucket(uint64_t hash) const;
+		size_t alternate_bucket(uint64_t hash) const;
+		static uint8_t get_tag(uint64_t hash);
+		bool find_in_bucket(size_t bucket, uint8_t tag, const V& value, size_t& slot) const;
+		bool place(const V& value);
+		bool place_in_bucket(size_t bucket, uint8_t tag, const V& value);
+		bool find_eviction_path(size_t first, size_t second, std::vector<bfs_node>& nodes, int& last, size_t& free_bucket, size_t& free_slot) const;
+		void drain_stash(size_t bucket);
+		void make_room();
+		void new_hash();
+		bool degenerate() const;
+};
+
+//=========  PUBLIC FUNCITONS  =============
+
+template<	typename V, typename H, typename C>
+void hashtable_cuckoo<V, H, C>::insert(const V& value) {
+	if (contains(value)) return;
+
+	if (!place(value)) {
+		if (stash.size() < STASH_SIZE || degenerate()) {
+			stash.push_back(value);
+		} else {
+			//no eviction path and the stash is full
+			make_room();
+			insert(value);
+			return;
+		}
+	}
+	count++;
+}
+
+template<	typename V, typename H, typename C>
+void hashtable_cuckoo<V, H, C>::erase(const V& value) {
+	uint64_t hash = get_hash(value);
+	uint8_t tag = get_tag(hash);
+	size_t slot;
+
+	size_t buckets[2] = { primary_bucket(hash), alternate_bucket(hash) };
+	for (size_t bucket : buckets) {
+		if (find_in_bucket(bucket, tag, value, slot)) {
+			data[bucket].tags[slot] = 0;
+			count--;
+			drain_stash(bucket);
+			return;
+		}
+	}
+
+	for (size_t i = 0; i < stash.size(); i++) {
+		if (C()(stash[i], value)) {
+			stash.erase(stash.begin() + i);
+			count--;
+			return;
+		}
+	}
+}
+
+template<	typename V, typename H, typename C>
+bool hashtable_cuckoo<V, H, C>::contains(const V& value) const {
+	uint64_t hash = get_hash(value);
+	uint8_t tag = get_tag(hash);
+	size_t slot;
+
+	if (find_in_bucket(primary_bucket(hash), tag, value, slot)) return true;
+	if (find_in_bucket(alternate_bucket(hash), tag, value, slot)) return true;
+
+	//the stash is empty unless the table is close to its limit, and holds at most STASH_SIZE values
+	for (const V& item : stash) {
+		if (C()(item, value)) return true;
+	}
+	return false;
+}
+
+template<	typename V, typename H, typename C>
+void hashtable_cuckoo<V, H, C>::rehash(size_t new_n_buckets) {
+	bucket_vector old_data;
+	old_data.swap(data);
+	std::vector<V> old_stash;
+	old_stash.swap(stash);
+	size_t old_n_buckets = n_buckets;
+
+	n_buckets = bucket_count_for(std::max(new_n_buckets, count));
+	if (n_buckets != old_n_buckets)
+		reseeds = 0;
+	bool success;
+	do {
+		data = bucket_vector(n_buckets);
+		stash.clear();
+		success = true;
+
+		for (size_t b = 0; b < old_n_buckets && success; b++) {
+			for (size_t i = 0; i < SLOTS && success; i++) {
+				if (old_data[b].tags[i] == 0) continue;
+				if (!place(old_data[b].values[i])) {
+					if (stash.size() < STASH_SIZE || degenerate())
+						stash.push_back(old_data[b].values[i]);
+					else
+						success = false;
+				}
+			}
+		}
+		for (size_t i = 0; i < old_stash.size() && success; i++) {
+			if (!place(old_stash[i])) {
+				if (stash.size() < STASH_SIZE || degenerate())
+					stash.push_back(old_stash[i]);
+				else
+					success = false;
+			}
+		}
+
+		if (!success && count * 2 >= n_buckets * SLOTS) {
+			n_buckets *= 2;
+			reseeds = 0;
+		} else if (!success) {
+			new_hash();
+		}
+	} while (!success);
+}
+
+template<	typename V, typename H, typename C>
+void hashtable_cuckoo<V, H, C>::clear() {
+	for (Bucket& bucket : data)
+		std::fill(bucket.tags, bucket.tags + SLOTS, 0);
+	stash.clear();
+	count = 0;
+}
+
+template<typename V, typename H, typename C>
+double hashtable_cuckoo<V, H, C>::load_factor() const {
+	return (double)count / capacity();
+}
+
+template<typename V, typename H, typename C>
+size_t hashtable_cuckoo<V, H, C>::size() const {
+	return count;
+}
+
+template<typename V, typename H, typename C>
+size_t hashtable_cuckoo<V, H, C>::capacity() const {
+	return n_buckets * SLOTS;
+}
+
+template<typename V, typename H, typename C>
+bool hashtable_cuckoo<V, H, C>::empty() const {
+	return count == 0;
+}
+
+template<typename V, typename H, typename C>
+size_t hashtable_cuckoo<V, H, C>::stash_size() const {
+	return stash.size();
+}
+
+template<typename V, typename H, typename C>
+typename flood_guard<V, H, C>::mode_type hashtable_cuckoo<V, H, C>::hash_mode() const {
+	return guard.get_mode();
+}
+
+//=========  PRIVATE FUNCITONS  =============
+
+template<typename V, typename H, typename C>
+size_t hashtable_cuckoo<V, H, C>::bucket_count_for(size_t capacity) {
+	size_t n = 2;
+	while (n * SLOTS < capacity)
+		n *= 2;
+	return n;
+}
+
+template<typename V, typename H, typename C>
+uint64_t hashtable_cuckoo<V, H, C>::get_hash(const V& value) const {
+	//seeded and keyed hashes are mixed already
+	if (guard.get_mode() == flood_guard<V, H, C>::plain)
+		return mixed_hash<H>(value);
+	return guard(value);
+}
+
+template<typename V, typename H, typename C>
+size_t hashtable_cuckoo<V, H, C>::primary_bucket(uint64_t hash) const {
+	return (size_t)hash & (n_buckets - 1);
+}
+
+template<typename V, typename H, typename C>
+size_t hashtable_cuckoo<V, H, C>::alternate_bucket(uint64_t hash) const {
+	size_t bucket = (size_t)(hash >> 32) & (n_buckets - 1);
+	//both candidates must differ, otherwise the value has no alternative
+	if (bucket == primary_bucket(hash))
+		bucket ^= 1;
+	return bucket;
+}
+
+template<typename V, typename H, typename C>
+uint8_t hashtable_cuckoo<V, H, C>::get_tag(uint64_t hash) {
+	uint8_t tag = (uint8_t)(hash >> 56);
+	return tag == 0 ? 1 : tag;
+}
+
+template<typename V, typename H, typename C>
+bool hashtable_cuckoo<V, H, C>::find_in_bucket(size_t bucket, uint8_t tag, const V& value, size_t& slot) const {
+	const Bucket& b = data[bucket];
+	for (size_t i = 0; i < SLOTS; i++) {
+		//the tag filters out almost all non-matching slots before the value is compared
+		if (b.tags[i] == tag && C()(b.values[i], value)) {
+			slot = i;
+			return true;
+		}
+	}
+	return false;
+}
+
+template<typename V, typename H, typename C>
+bool hashtable_cuckoo<V, H, C>::place_in_bucket(size_t bucket, uint8_t tag, const V& value) {
+	Bucket& b = data[bucket];
+	for (size_t i = 0; i < SLOTS; i++) {
+		if (b.tags[i] == 0) {
+			b.values[i] = value;
+			b.tags[i] = tag;
+			return true;
+		}
+	}
+	return false;
+}
+
+//puts a value that is not contained yet into one of its buckets, evicting other values if necessary.
+//returns false if no eviction path was found, the table is unchanged in that case
+template<typename V, typename H, typename C>
+bool hashtable_cuckoo<V, H, C>::place(const V& value) {
+	uint64_t hash = get_hash(value);
+	uint8_t tag = get_tag(hash);
+	size_t first = primary_bucket(hash);
+	size_t second = alternate_bucket(hash);
+
+	if (place_in_bucket(first, tag, value)) return true;
+	if (place_in_bucket(second, tag, value)) return true;
+
+	std::vector<bfs_node> nodes;
+	int last;
+	size_t free_bucket, free_slot;
+	if (!find_eviction_path(first, second, nodes, last, free_bucket, free_slot))
+		return false;
+
+	//move the values along the path, starting with the one next to the free slot
+	int node = last;
+	while (node != -1) {
+		Bucket& from = data[nodes[node].bucket];
+		Bucket& to = data[free_bucket];
+		to.values[free_slot] = from.values[nodes[node].slot];
+		to.tags[free_slot] = from.tags[nodes[node].slot];
+		free_bucket = nodes[node].bucket;
+		free_slot = nodes[node].slot;
+		node = nodes[node].parent;
+	}
+
+	data[free_bucket].values[free_slot] = value;
+	data[free_bucket].tags[free_slot] = tag;
+	return true;
+}
+
+//breadth first search for the shortest chain of moves that frees a slot in first or second.
+//last is the final node of the chain, free_bucket/free_slot the empty slot it moves into
+template<typename V, typename H, typename C>
+bool hashtable_cuckoo<V, H, C>::find_eviction_path(size_t first, size_t second, std::vector<bfs_node>& nodes, int& last, size_t& free_bucket, size_t& free_slot) const {
+	for (size_t i = 0; i < SLOTS; i++) {
+		nodes.push_back({ first, i, -1 });
+		nodes.push_back({ second, i, -1 });
+	}
+
+	for (size_t n = 0; n < nodes.size() && n < MAX_BFS_NODES; n++) {
+		const bfs_node current = nodes[n];
+		uint64_t hash = get_hash(data[current.bucket].values[current.slot]);
+		size_t target = primary_bucket(hash) == current.bucket ? alternate_bucket(hash) : primary_bucket(hash);
+
+		const Bucket& b = data[target];
+		for (size_t i = 0; i < SLOTS; i++) {
+			if (b.tags[i] == 0) {
+				last = (int)n;
+				free_bucket = target;
+				free_slot = i;
+				return true;
+			}
+		}
+		for (size_t i = 0; i < SLOTS && nodes.size() < MAX_BFS_NODES; i++) {
+			//a slot may appear only once on a path, otherwise the moves would overwrite each other
+			bool on_path = false;
+			for (int p = (int)n; p != -1 && !on_path; p = nodes[p].parent)
+				on_path = nodes[p].bucket == target && nodes[p].slot == i;
+			if (!on_path)
+				nodes.push_back({ target, i, (int)n });
+		}
+	}
+	return false;
+}
+
+//an erase freed one slot in bucket, a stashed value with bucket as a candidate moves into it
+template<typename V, typename H, typename C>
+void hashtable_cuckoo<V, H, C>::drain_stash(size_t bucket) {
+	for (size_t i = 0; i < stash.size(); i++) {
+		uint64_t hash = get_hash(stash[i]);
+		if (primary_bucket(hash) == bucket || alternate_bucket(hash) == bucket) {
+			place_in_bucket(bucket, get_tag(hash), stash[i]);
+			stash.erase(stash.begin() + i);
+			return;
+		}
+	}
+}
+
+//the stash is full: a table at half load or more grows. Below that the hash function maps too
+//many values to the same buckets and growing would not help, the table rehashes with a new hash
+template<typename V, typename H, typename C>
+void hashtable_cuckoo<V, H, C>::make_room() {
+	if ((count + 1) * 2 >= n_buckets * SLOTS) {
+		rehash(n_buckets * SLOTS * 2);
+	} else {
+		new_hash();
+		rehash(n_buckets * SLOTS);
+	}
+}
+
+//escalates plain -> seeded -> keyed, then fresh keys
+template<typename V, typename H, typename C>
+void hashtable_cuckoo<V, H, C>::new_hash() {
+	if (guard.can_escalate())
+		guard.escalate();
+	else
+		guard.reseed();
+	reseeds++;
+}
+
+//H returns equal hashes for distinct values and no key separates them, e.g. a constant hash of a
+//type flood_guard cannot key. Only then the stash grows beyond STASH_SIZE
+template<typename V, typename H, typename C>
+bool hashtable_cuckoo<V, H, C>::degenerate() const {
+	return reseeds >= MAX_RESEEDS && !guard.can_escalate();
+}
+
+//==========  DEFINITION OF ITERATOR CLASS ==============
+
+
+template<typename V, typename H, typename C>
+class hashtable_cuckoo<V, H, C>::const_iterator : public iterator_base {
+
+	private:
+		const hashtable_cuckoo* table; //table for accessing buckets and stash
+		size_t position; //slot index, positions past the last bucket slot index the stash
+
+		size_t end_position() const {
+			return table->n_buckets * SLOTS + table->stash.size();
+		}
+
+		bool occupied(size_t pos) const {
+			if (pos >= table->n_buckets * SLOTS) return true; //stash entries are always occupied
+			return table->data[pos / SLOTS].tags[pos % SLOTS] != 0;
+		}
+
+	public:
+
+		const_iterator(const hashtable_cuckoo* table, size_t position)
+										: table(table), position(position) {
+			if (position == 0) {//begin() called -> find first element
+				while (this->position != end_position() && !occupied(this->position))
+					this->position++;
+			}
+			//no action needed for end()
+		}
+
+		size_t get_position() const {
+			return position;
+		}
+
+		bool hasNext() {
+			size_t next = position;
+			while (next != end_position() && !occupied(next))
+				next++;
+			return next != end_position();
+		}
+
+		bool operator==(const_iterator const& rhs) const {
+			return position == rhs.get_position();
+		}
+
+		bool operator!=(const_iterator const& rhs) const {
+			return position != rhs.get_position();
+		}
+
+		const_reference operator*() const {
+			size_t slots = table->n_buckets * SLOTS;
+			if (position >= slots)
+				return table->stash[position - slots];
+			return table->data[position / SLOTS].values[position % SLOTS];
+		}
+
+		const_pointer operator->() const {
+			return &(**this);
+		}
+
+		const_iterator& operator++() {
+			if (position != end_position()) {
+				do {
+					position++;
+				} while (position != end_position() && !occupied(position));
+			}
+			return *this;
+		}
+
+		const_iterator& operator--() {
+			if (position != 0) {
+				do {
+					position--;
+				} while (position != 0 && !occupied(position));
+			}
+			return *this;
+		}
+
+		const_iterator operator++(int) {
+			const_iterator temp = *this; // Preserve state because of post-increment
+			++(*this);
+			return temp;
+		}
+
+		const_iterator operator--(int) {
+			const_iterator temp = *this; //preserve state because post increment
+			--(*this);
+			return temp;
+		}
+};
+
+template<typename V, typename H, typename C>
+bool operator==(const hashtable_cuckoo<V, H, C>& lhs, const hashtable_cuckoo<V, H, C>& rhs) {
+	if (lhs.size() != rhs.size()) return false;
+
+	for (const V& item : lhs) {
+		if (!rhs.contains(item)) return false;
+	}
+	return true;
+}
@@ -0,0 +1,466 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <ostream>
+#include <vector>
+#include "aligned_allocator.h"
+#include "control_bytes.h"
+#include "flood_guard.h"
+#include "hash.h"
+#include "hashtable.h"
+
+
+
+//hopscotch hashing: every value is stored within HOP_RANGE slots of its home slot.
+//The home slot keeps a bitmap of the neighborhood slots holding its values,
+//so a lookup reads one bitmap and only the slots whose bit is set.
+//Inserts probe linearly for a free slot and move it towards the home slot by
+//displacing values that stay inside their own neighborhood.
+//Values that find no slot go to an overflow of at most OVERFLOW_SIZE values. A full overflow grows
+//the table, or below half load switches to a new seeded or keyed hash (see flood_guard.h)
+template<	typename V,
+					typename H = default_hash<V>,
+					typename C = std::equal_to<V>>
+class hashtable_hopscotch : hashtable<V, H, C> {
+
+	public:
+
+		static const size_t HOP_RANGE = 32;
+		static const size_t MAX_PROBE = 1024;
+		static const size_t OVERFLOW_SIZE = 8;
+		//new hashes tried at one capacity before the overflow takes values no hash separates
+		static const size_t MAX_RESEEDS = 4;
+
+		hashtable_hopscotch(size_t capacity) {
+			cap = slot_count_for(capacity);
+			data = slot_vector(cap);
+			count = 0;
+			reseeds = 0;
+		}
+
+		~hashtable_hopscotch() {}
+		void insert(const V& value)override;
+		void erase(const V& value)override;
+		bool contains(const V& value) const override;
+		void rehash(size_t new_n_buckets)override;
+		void clear()override;
+
+		double load_factor() const override;
+		size_t size() const override;
+		size_t capacity() const override;
+		bool empty() const override;
+
+		size_t overflow_size() const;
+		typename flood_guard<V, H, C>::mode_type hash_mode() const;
+
+		friend std::ostream& operator<<(std::ostream& os, const hashtable_hopscotch<V, H, C>& ht) {
+			for (const Slot& slot : ht.data) {
+				if (slot.occupied)
+					os << slot.value << " ";
+			}
+			for (const V& item : ht.overflow)
+				os << item << " ";
+			os << "\n";
+			return os;
+		}
+
+		class const_iterator;
+
+		const_iterator begin() const {
+			return const_iterator(this, 0);
+		}
+
+		const_iterator end() const {
+			return const_iterator(this, cap + overflow.size());
+		}
+
+		using iterator_category = std::bidirectional_iterator_tag;
+		using value_type = V const;
+		using difference_type = std::ptrdiff_t;
+		using const_pointer = V const*;
+		using const_reference = V const&;
+
+		typedef std::iterator<std::bidirectional_iterator_tag, value_type, difference_type, const_pointer,
+			const_reference> iterator_base;
+
+		//hop_info bit i set -> slot (home + i) holds a value whose home is this slot
+		struct Slot {
+			uint32_t hop_info;
+			bool occupied;
+			V value;
+		};
+
+	private:
+		typedef std::vector<Slot, huge_page_allocator<Slot>> slot_vector;
+
+		slot_vector data;
+		std::vector<V> overflow; //only used when the hash function maps too many values to one neighborhood
+		size_t count;
+		size_t cap; //always a power of two
+		flood_guard<V, H, C> guard;
+		size_t reseeds; //new hashes since the capacity last changed
+
+		static size_t slot_count_for(size_t capacity);
+		size_t home_of(const V& value) const;
+		size_t distance(size_t from, size_t to) const;
+		size_t indexOf(const V& value) const;
+		bool place(const V& value);
+		bool move_closer(size_t& free);
+		void make_room();
+		void new_hash();
+		bool degenerate() const;
+};
+
+//=========  PUBLIC FUNCITONS  =============
+
+template<	typename V, typename H, typename C>
+void hashtable_hopscotch<V, H, C>::insert(const V& value) {
+	if (contains(value)) return;
+
+	if ((double)(count + 1) / cap > 0.9) {
+		rehash(cap * 2);
+	}
+
+	if (!place(value)) {
+		if (overflow.size() < OVERFLOW_SIZE || degenerate()) {
+			overflow.push_back(value);
+		} else {
+			make_room();
+			insert(value);
+			return;
+		}
+	}
+	count++;
+}
+
+template<	typename V, typename H, typename C>
+void hashtable_hopscotch<V, H, C>::erase(const V& value) {
+	size_t index = indexOf(value);
+	if (index != (size_t)-1) {
+		size_t home = home_of(value);
+		data[index].occupied = false;
+		data[home].hop_info &= ~(uint32_t(1) << distance(home, index));
+		count--;
+		return;
+	}
+
+	for (size_t i = 0; i < overflow.size(); i++) {
+		if (C()(overflow[i], value)) {
+			overflow.erase(overflow.begin() + i);
+			count--;
+			return;
+		}
+	}
+}
+
+template<	typename V, typename H, typename C>
+bool hashtable_hopscotch<V, H, C>::contains(const V& value) const {
+	if (indexOf(value) != (size_t)-1) return true;
+
+	for (const V& item : overflow) {
+		if (C()(item, value)) return true;
+	}
+	return false;
+}
+
+template<	typename V, typename H, typename C>
+void hashtable_hopscotch<V, H, C>::rehash(size_t new_n_buckets) {
+	slot_vector old_data;
+	old_data.swap(data);
+	std::vector<V> old_overflow;
+	old_overflow.swap(overflow);
+
+	size_t old_cap = cap;
+	cap = slot_count_for(std::max(new_n_buckets, count));
+	if (cap != old_cap)
+		reseeds = 0;
+	bool success;
+	do {
+		data = slot_vector(cap);
+		overflow.clear();
+		success = true;
+
+		for (size_t i = 0; i < old_data.size() && success; i++) {
+			if (old_data[i].occupied && !place(old_data[i].value)) {
+				if (overflow.size() < OVERFLOW_SIZE || degenerate())
+					overflow.push_back(old_data[i].value);
+				else
+					success = false;
+			}
+		}
+		for (size_t i = 0; i < old_overflow.size() && success; i++) {
+			if (!place(old_overflow[i])) {
+				if (overflow.size() < OVERFLOW_SIZE || degenerate())
+					overflow.push_back(old_overflow[i]);
+				else
+					success = false;
+			}
+		}
+
+		if (!success && count * 2 >= cap) {
+			cap *= 2;
+			reseeds = 0;
+		} else if (!success) {
+			new_hash();
+		}
+	} while (!success);
+}
+
+template<	typename V, typename H, typename C>
+void hashtable_hopscotch<V, H, C>::clear() {
+	for (Slot& slot : data) {
+		slot.hop_info = 0;
+		slot.occupied = false;
+	}
+	overflow.clear();
+	count = 0;
+}
+
+template<typename V, typename H, typename C>
+double hashtable_hopscotch<V, H, C>::load_factor() const {
+	return (double)count / cap;
+}
+
+template<typename V, typename H, typename C>
+size_t hashtable_hopscotch<V, H, C>::size() const {
+	return count;
+}
+
+template<typename V, typename H, typename C>
+size_t hashtable_hopscotch<V, H, C>::capacity() const {
+	return cap;
+}
+
+template<typename V, typename H, typename C>
+bool hashtable_hopscotch<V, H, C>::empty() const {
+	return count == 0;
+}
+
+template<typename V, typename H, typename C>
+size_t hashtable_hopscotch<V, H, C>::overflow_size() const {
+	return overflow.size();
+}
+
+template<typename V, typename H, typename C>
+typename flood_guard<V, H, C>::mode_type hashtable_hopscotch<V, H, C>::hash_mode() const {
+	return guard.get_mode();
+}
+
+//=========  PRIVATE FUNCITONS  =============
+
+template<typename V, typename H, typename C>
+size_t hashtable_hopscotch<V, H, C>::slot_count_for(size_t capacity) {
+	//the table must be at least one neighborhood wide, otherwise neighborhoods overlap themselves
+	size_t n = HOP_RANGE;
+	while (n < capacity)
+		n *= 2;
+	return n;
+}
+
+template<typename V, typename H, typename C>
+size_t hashtable_hopscotch<V, H, C>::home_of(const V& value) const {
+	//seeded and keyed hashes are mixed already
+	if (guard.get_mode() == flood_guard<V, H, C>::plain)
+		return (size_t)mixed_hash<H>(value) & (cap - 1);
+	return guard(value) & (cap - 1);
+}
+
+template<typename V, typename H, typename C>
+size_t hashtable_hopscotch<V, H, C>::distance(size_t from, size_t to) const {
+	return (to - from) & (cap - 1);
+}
+
+template<typename V, typename H, typename C>
+size_t hashtable_hopscotch<V, H, C>::indexOf(const V& value) const {
+	size_t home = home_of(value);
+	uint32_t bits = data[home].hop_info;
+	while (bits != 0) {
+		unsigned offset = lowest_bit(bits);
+		size_t index = (home + offset) & (cap - 1);
+		if (C()(data[index].value, value))
+			return index;
+		bits &= bits - 1; //clear lowest bit
+	}
+	return -1;
+}
+
+//puts a value that is not contained yet into the neighborhood of its home slot.
+//returns false if no free slot could be moved into the neighborhood
+template<typename V, typename H, typename C>
+bool hashtable_hopscotch<V, H, C>::place(const V& value) {
+	size_t home = home_of(value);
+
+	//linear probe for the closest free slot
+	size_t free = home;
+	size_t probes = 0;
+	while (data[free].occupied) {
+		free = (free + 1) & (cap - 1);
+		if (++probes == (cap < MAX_PROBE ? cap : MAX_PROBE)) return false;
+	}
+
+	//hop the free slot backwards until it is inside the neighborhood
+	while (distance(home, free) >= HOP_RANGE) {
+		if (!move_closer(free)) return false;
+	}
+
+	data[free].value = value;
+	data[free].occupied = true;
+	data[home].hop_info |= uint32_t(1) << distance(home, free);
+	return true;
+}
+
+//moves a value from before the free slot into it while keeping that value inside its own neighborhood.
+//free is updated to the slot that was vacated
+template<typename V, typename H, typename C>
+bool hashtable_hopscotch<V, H, C>::move_closer(size_t& free) {
+	//candidate home slots, furthest first so the free slot moves as far as possible
+	for (size_t d = HOP_RANGE - 1; d > 0; d--) {
+		size_t home = (free - d) & (cap - 1);
+		uint32_t bits = data[home].hop_info;
+		if (bits != 0) {
+			size_t offset = lowest_bit(bits);
+			if (offset >= d) continue; //no value of this home is before the free slot
+			size_t index = (home + offset) & (cap - 1);
+
+			data[free].value = data[index].value;
+			data[free].occupied = true;
+			data[index].occupied = false;
+			data[home].hop_info &= ~(uint32_t(1) << offset);
+			data[home].hop_info |= uint32_t(1) << d;
+			free = index;
+			return true;
+		}
+	}
+	return false;
+}
+
+//the overflow is full: a table at half load or more grows. Below that the hash function maps too
+//many values to one neighborhood and growing would not help, the table rehashes with a new hash
+template<typename V, typename H, typename C>
+void hashtable_hopscotch<V, H, C>::make_room() {
+	if ((count + 1) * 2 >= cap) {
+		rehash(cap * 2);
+	} else {
+		new_hash();
+		rehash(cap);
+	}
+}
+
+//escalates plain -> seeded -> keyed, then fresh keys
+template<typename V, typename H, typename C>
+void hashtable_hopscotch<V, H, C>::new_hash() {
+	if (guard.can_escalate())
+		guard.escalate();
+	else
+		guard.reseed();
+	reseeds++;
+}
+
+//H returns equal hashes for distinct values and no key separates them, e.g. a constant hash of a
+//type flood_guard cannot key. Only then the overflow grows beyond OVERFLOW_SIZE
+template<typename V, typename H, typename C>
+bool hashtable_hopscotch<V, H, C>::degenerate() const {
+	return reseeds >= MAX_RESEEDS && !guard.can_escalate();
+}
+
+//==========  DEFINITION OF ITERATOR CLASS ==============
+
+
+template<typename V, typename H, typename C>
+class hashtable_hopscotch<V, H, C>::const_iterator : public iterator_base {
+
+	private:
+		const hashtable_hopscotch* table; //table for accessing slots and overflow
+		size_t position; //slot index, positions past the last slot index the overflow values
+
+		size_t end_position() const {
+			return table->cap + table->overflow.size();
+		}
+
+		bool occupied(size_t pos) const {
+			if (pos >= table->cap) return true; //overflow values are always occupied
+			return table->data[pos].occupied;
+		}
+
+	public:
+
+		const_iterator(const hashtable_hopscotch* table, size_t position)
+										: table(table), position(position) {
+			if (position == 0) {//begin() called -> find first element
+				while (this->position != end_position() && !occupied(this->position))
+					this->position++;
+			}
+			//no action needed for end()
+		}
+
+		size_t get_position() const {
+			return position;
+		}
+
+		bool hasNext() {
+			size_t next = position;
+			while (next != end_position() && !occupied(next))
+				next++;
+			return next != end_position();
+		}
+
+		bool operator==(const_iterator const& rhs) const {
+			return position == rhs.get_position();
+		}
+
+		bool operator!=(const_iterator const& rhs) const {
+			return position != rhs.get_position();
+		}
+
+		const_reference operator*() const {
+			if (position >= table->cap)
+				return table->overflow[position - table->cap];
+			return table->data[position].value;
+		}
+
+		const_pointer operator->() const {
+			return &(**this);
+		}
+
+		const_iterator& operator++() {
+			if (position != end_position()) {
+				do {
+					position++;
+				} while (position != end_position() && !occupied(position));
+			}
+			return *this;
+		}
+
+		const_iterator& operator--() {
+			if (position != 0) {
+				do {
+					position--;
+				} while (position != 0 && !occupied(position));
+			}
+			return *this;
+		}
+
+		const_iterator operator++(int) {
+			const_iterator temp = *this; // Preserve state because of post-increment
+			++(*this);
+			return temp;
+		}
+
+		const_iterator operator--(int) {
+			const_iterator temp = *this; //preserve state because post increment
+			--(*this);
+			return temp;
+		}
+};
+
+template<typename V, typename H, typename C>
+bool operator==(const hashtable_hopscotch<V, H, C>& lhs, const hashtable_hopscotch<V, H, C>& rhs) {
+	if (lhs.size() != rhs.size()) return false;
+
+	for (const V& item : lhs) {
+		if (!rhs.contains(item)) return false;
+	}
+	return true;
+}
@@ -1,15 +1,27 @@
 #pragma once
 #include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
 #include <functional>
 #include <iterator>
 #include <list>
 #include <ostream>
+#include <type_traits>
+#include <utility>
 #include <vector>
-
+#include "aligned_allocator.h"
+#include "bloom_filter.h"
+#include "control_bytes.h"
+#include "flood_guard.h"
+#include "hash.h"
+#include "hashtable.h"
+#include "instrumentation.h"
+#include "parallel.h"
 
 
 template<	typename V,
-	typename H = std::hash<V>,
+	typename H = default_hash<V>,
 	typename C = std::equal_to<V>>
 	class hashtable_oa : hashtable<V,H,C>{//sc-> separate chaining
 	
@@ -17,29 +29,121 @@ template<	typename V,
 
 		hashtable_oa(size_t capacity) {			
 			cap = capacity;
-			data = std::vector<Entry>(cap);
-			for(Entry item : data){
-				item.state = 0;
-			}
+			data = entry_vector(cap);
+			ctrl = control_vector(cap); //value initialized -> all states 0
 			count = 0;
+			filter_fp_rate = 0;
+			filter_max_bytes = 0;
+			filter_stale = 0;
+			max_count = 0;
+			hand = 0;
+			hits = 0;
+			misses = 0;
+			evicted = 0;
+		}
+
+		hashtable_oa(const hashtable_oa& other) = default;
+
+		//the moved-from table is left empty without slots, the next insert allocates them.
+		//Moves do not allocate, so a std::vector of tables moves them when it grows
+		hashtable_oa(hashtable_oa&& other) noexcept : count(0), cap(0), filter_fp_rate(0), filter_max_bytes(0),
+			filter_stale(0), max_count(0), hand(0), hits(0), misses(0), evicted(0) {
+			swap(other);
+		}
+
+		hashtable_oa& operator=(const hashtable_oa& other) = default;
+
+		hashtable_oa& operator=(hashtable_oa&& other) noexcept {
+			if (this != &other) {
+				hashtable_oa moved(std::move(other));
+				swap(moved);
+			}
+			return *this;
 		}
 
 		~hashtable_oa() {}
 		void insert(const V& value)override;
+		void insert(V&& value);
+		template<typename... Args>
+		void emplace(Args&&... args);
 		void erase(const V& value)override;
-		bool contains(const V& value)override;
+		bool contains(const V& value) const override;
 		void rehash(size_t new_n_buckets)override;
 		void clear()override;
+		void swap(hashtable_oa& other);
 
 		double load_factor() const override;
 		size_t size() const override;
 		size_t capacity() const override;
 		bool empty() const override;
+		//deleted slots, and the mean number of slots a successful lookup visits, sampled from up to
+		//1024 values. Both scan the control bytes, hashtable_adaptive reads them before a rehash
+		size_t deleted_slots() const;
+		double mean_probe_length() const;
+
+		//set algebra. The smaller set is probed against the larger one
+		void merge(const hashtable_oa& other);
+		//moves the values of other into this table and leaves other empty, duplicates are destroyed.
+		//A larger plain table is taken over as a whole and the smaller one is moved into it
+		void merge(hashtable_oa&& other);
+		void intersect(const hashtable_oa& other, execution_policy policy = seq);
+		void difference(const hashtable_oa& other, execution_policy policy = seq);
+		bool is_subset(const hashtable_oa& other, execution_policy policy = seq) const;
+		bool equals(const hashtable_oa& other, execution_policy policy = seq) const;
+
+		//erases every value with pred(value) == true and returns the number of erased values.
+		//One pass over the slots, afterwards the remaining values are moved back along their probe
+		//sequences, so neither new nor old deleted slots are left. With par(n) pred is called concurrently
+		template<typename P>
+		size_t erase_if(P pred, execution_policy policy = seq);
+
+		//partitions(n) splits the slots into n disjoint ranges of equal length, some may be empty.
+		//The ranges can be scanned concurrently, also by OpenMP, TBB or std::execution
+		class partition;
+		std::vector<partition> partitions(size_t n) const;
+		//calls fn(value) for every value, with par(n) concurrently on n partitions
+		template<typename F>
+		void for_each(execution_policy policy, F fn) const;
+
+		//Bloom filter checked by contains() before the probe sequence is walked.
+		//Meant for tables where most lookups miss, rebuilt on rehash and after many erases
+		void enable_bloom_filter(double fp_rate = 0.01, size_t max_bytes = 0);
+		void disable_bloom_filter();
+
+		//collision flooding: the table escalates from H to seeded and keyed hashing when an insert
+		//probes far beyond the expected run length. reseed() switches to seeded hashing right away
+		void reseed();
+		typename flood_guard<V, H, C>::mode_type hash_mode() const;
+
+#ifdef HASHTABLE_INSTRUMENTATION
+		//latency histograms and rehash callbacks of this table, see instrumentation.h.
+		//They stay with the table object, swap() and moves do not exchange them
+		table_stats& stats() const {
+			return instruments;
+		}
+#endif
+
+		//bounded cache mode: at most max_size values in a slot array that is allocated once and never grows.
+		//Inserting a new value into a full cache evicts one chosen by CLOCK: a hit of contains() or insert()
+		//sets the reference bit of the slot, the clock hand clears set bits and evicts the first value
+		//without one. Evictions shift the following values back instead of leaving deleted slots.
+		//In cache mode contains() counts hits and misses and must not be called concurrently.
+		//The set algebra looks values up without counting, so its par(n) workers may share a cache
+		void enable_cache(size_t max_size);
+		//max size from a budget for the slot array, values owning heap memory need more
+		void enable_cache_bytes(size_t bytes);
+		void disable_cache();
+		//fn(std::move(value)) is called for every evicted value, before it is destroyed
+		void on_evict(std::function<void(V&&)> fn);
+		size_t max_size() const;
+		size_t cache_hits() const;
+		size_t cache_misses() const;
+		size_t cache_evictions() const;
 
 		friend std::ostream& operator<<(std::ostream& os, const hashtable_oa<V, H, C>& ht) {						
-			for (const Entry item : ht.data) {
-				if(item.state == 2){
-					os << item.value << " ";
+			for (size_t i = 0; i < ht.cap; i++) {
+				if(ht.ctrl[i] == 2){
+					os << ht.data[i].value << " ";
 				}
 			}
 			os << "\n";
@@ -50,11 +154,11 @@ template<	typename V,
 		class const_iterator;
 
 		const_iterator begin() const {
-			return const_iterator(&data, data.begin());
+			return const_iterator(&data, &ctrl, data.begin());
 		}
 
 		const_iterator end() const {
-			return const_iterator(&data, data.end());
+			return const_iterator(&data, &ctrl, data.end());
 		}
 
 		using iterator_category = std::bidirectional_iterator_tag;
@@ -67,20 +171,59 @@ template<	typename V,
 			const_reference> iterator_base;
 
 
-		//state = 0 -> empty
-		//state = 1 -> deleted
-		//state = 2 -> occupied
-		struct Entry {
+		//referenced = CLOCK reference bit of the cache mode, set by hits
+		//aligned to the next power of two of its size (at most a cache line),
+		//so in the cache line aligned slot array no entry straddles two lines
+		struct alignas(line_alignment(sizeof(V) + 1, alignof(V))) Entry {
 			V value;
-			int state; 
+			mutable unsigned char referenced;
 		};
 
+		typedef std::vector<Entry, huge_page_allocator<Entry>> entry_vector;
+
+		//the state of slot i is ctrl[i], packed apart from the entries for the vectorized scans of control_bytes.h:
+		//0 -> empty
+		//1 -> deleted
+		//2 -> occupied
+		//3 -> freed by erase_if, only during the compaction
+		typedef std::vector<unsigned char, huge_page_allocator<unsigned char>> control_vector;
+
 	private:
-		std::vector<Entry> data;
+		entry_vector data;
+		control_vector ctrl;
 		size_t count;
 		size_t cap;
-		int get_hash_index(const V& value) const;
+		flood_guard<V, H, C> guard; //hash function in use, H unless a flood was detected
+		TABLE_STATS_MEMBER
 		size_t indexOf(const V& value) const;
+		size_t find_slot(const V& value) const;
+		size_t probe(const V& value, size_t hash, size_t& free, size_t& probes, size_t& deleted) const;
+		void place(V&& value);
+		void inserted(size_t hash, size_t probes, size_t deleted);
+		size_t next_empty(size_t index) const;
+		size_t count_occupied(execution_policy policy) const;
+		const_iterator iterator_at(size_t slot) const;
+		void compact(size_t start, size_t end);
+		void erase_matching(const hashtable_oa& other, bool in_other, execution_policy policy);
+		void reserve(size_t n);
+
+		blocked_bloom_filter filter;
+		double filter_fp_rate;
+		size_t filter_max_bytes;
+		size_t filter_stale; //erased values whose bits are still set in the filter
+		void rebuild_filter();
+		void filter_erased(size_t n);
+
+		size_t max_count; //0 -> unbounded
+		size_t hand; //CLOCK hand, the next slot to look at for a victim
+		mutable size_t hits;
+		mutable size_t misses;
+		size_t evicted;
+		std::function<void(V&&)> evict_callback;
+		static size_t cache_slots(size_t max_size);
+		size_t clock_victim();
+		void evict();
+		void remove_at(size_t index);
 		
 };
 
@@ -88,71 +231,149 @@ template<	typename V,
 
 template<	typename V, typename H, typename C>
 void hashtable_oa<V, H, C>::insert(const V& value) {
-	if (!contains(value)) {
-		int index = get_hash_index(value);
-		//find empty slot
-		while(data.at(index).state == 2){
-			index++;
-			//reset if end is reached. Because rehash is triggered 
-			//when the load factor is too high, there will always be a free slot, 
-			//so there cannot be an endless loop
-			if(index == cap)
-				index = 0;
-		}
-		data.at(index).value = value;
-		data.at(index).state = 2;
-
-		count++;
-		if (load_factor() > 0.75)
-			rehash(cap * 2);
+	TABLE_TIMER(inserts);
+	if (cap == 0) rehash(1); //moved from
+	size_t hash = guard(value), free, probes, deleted;
+	size_t index = probe(value, hash, free, probes, deleted);
+	if (index == (size_t)-1) {
+		if (max_count != 0 && count >= max_count) {
+			evict(); //may shift values, the free slot has to be searched again
+			probe(value, hash, free, probes, deleted);
+		}
+		data[free].value = value;
+		ctrl[free] = 2;
+		data[free].referenced = 0;
+		inserted(hash, probes, deleted);
+	} else if (max_count != 0) {
+		data[index].referenced = 1;
 	}
 }
 
+template<	typename V, typename H, typename C>
+void hashtable_oa<V, H, C>::insert(V&& value) {
+	TABLE_TIMER(inserts);
+	if (cap == 0) rehash(1); //moved from
+	size_t hash = guard(value), free, probes, deleted;
+	size_t index = probe(value, hash, free, probes, deleted);
+	if (index == (size_t)-1) {
+		if (max_count != 0 && count >= max_count) {
+			evict(); //may shift values, the free slot has to be searched again
+			probe(value, hash, free, probes, deleted);
+		}
+		data[free].value = std::move(value);
+		ctrl[free] = 2;
+		data[free].referenced = 0;
+		inserted(hash, probes, deleted);
+	} else if (max_count != 0) {
+		data[index].referenced = 1;
+	}
+}
+
+//the slot of a value is only known after hashing it ->
+//the value is constructed once and moved into its slot
+template<	typename V, typename H, typename C>
+template<typename... Args>
+void hashtable_oa<V, H, C>::emplace(Args&&... args) {
+	insert(V(std::forward<Args>(args)...));
+}
+
 template<	typename V, typename H, typename C>
 void hashtable_oa<V, H, C>::erase(const V& value) {
-	if (contains(value)) {
-		size_t index = indexOf(value);
-		data.at(index).state = 1;
-		count--;
+	TABLE_TIMER(erases);
+	size_t index = indexOf(value);
+	if (index == (size_t)-1)
+		return;
+	if (max_count != 0) {
+		remove_at(index); //a cache never rehashes, so it must not collect deleted slots
+		return;
 	}
+	ctrl[index] = 1;
+	count--;
+	filter_erased(1);
 }
 
 template<	typename V, typename H, typename C>
-bool hashtable_oa<V, H, C>::contains(const V& value) {
-	return indexOf(value) != -1;
+bool hashtable_oa<V, H, C>::contains(const V& value) const {
+	TABLE_TIMER(lookups);
+	size_t index = find_slot(value);
+	if (max_count != 0) {
+		if (index != (size_t)-1) {
+			hits++;
+			data[index].referenced = 1;
+		} else {
+			misses++;
+		}
+	}
+	return index != (size_t)-1;
 }
 
 template<	typename V, typename H, typename C>
 void hashtable_oa<V, H, C>::rehash(size_t new_n_buckets) {
-	auto old_data = data;
+	TABLE_REHASH_TIMER(cap, new_n_buckets, count);
+	if (max_count != 0)
+		new_n_buckets = std::max(new_n_buckets, cache_slots(max_count));
+	entry_vector old_data(new_n_buckets);
+	control_vector old_ctrl(new_n_buckets);
+	old_data.swap(data);
+	old_ctrl.swap(ctrl);
 
 	cap = new_n_buckets;
-	data = std::vector<hashtable_oa::Entry>(new_n_buckets, { V{}, 0 });
 	count = 0;
+	if (filter.enabled())
+		rebuild_filter(); //empty filter for the new capacity, filled by place
 
-	for (hashtable_oa::Entry& item : old_data) {		
-		if(item.state == 2){			
-			insert(item.value);		
-		}
+	for (size_t i = find_control(old_ctrl.data(), 0, old_ctrl.size(), 2); i < old_ctrl.size();
+		i = find_control(old_ctrl.data(), i + 1, old_ctrl.size(), 2)) {
+		place(std::move(old_data[i].value));
 	}
 }
 
 template<	typename V, typename H, typename C>
-int hashtable_oa<V, H, C>::get_hash_index(const V& value) const{
-	return H()(value) % (int)cap;
+void hashtable_oa<V, H, C>::swap(hashtable_oa& other) {
+	data.swap(other.data);
+	ctrl.swap(other.ctrl);
+	std::swap(count, other.count);
+	std::swap(cap, other.cap);
+	std::swap(guard, other.guard);
+	std::swap(filter, other.filter);
+	std::swap(filter_fp_rate, other.filter_fp_rate);
+	std::swap(filter_max_bytes, other.filter_max_bytes);
+	std::swap(filter_stale, other.filter_stale);
+	std::swap(max_count, other.max_count);
+	std::swap(hand, other.hand);
+	std::swap(hits, other.hits);
+	std::swap(misses, other.misses);
+	std::swap(evicted, other.evicted);
+	std::swap(evict_callback, other.evict_callback);
+}
+
+template<	typename V, typename H, typename C>
+void hashtable_oa<V, H, C>::reseed() {
+	guard.reseed();
+	rehash(cap);
+}
+
+template<	typename V, typename H, typename C>
+typename flood_guard<V, H, C>::mode_type hashtable_oa<V, H, C>::hash_mode() const {
+	return guard.get_mode();
 }
 
 template<	typename V, typename H, typename C>
 void hashtable_oa<V, H, C>::clear() {
-	for (Entry item : data) {
-		item.state = 0;
+	//values without resources are simply left behind, insert overwrites them
+	if (!std::is_trivially_destructible<V>::value) {
+		for (size_t i = find_control_not(ctrl.data(), 0, cap, 0); i < cap; i = find_control_not(ctrl.data(), i + 1, cap, 0))
+			data[i].value = V(); //releases the resources of the old value
 	}
+	std::fill(ctrl.begin(), ctrl.end(), 0);
 	count = 0;
+	filter.clear();
+	filter_stale = 0;
 }
 
 template<typename V, typename H, typename C>
 double hashtable_oa<V, H, C>::load_factor() const {
-	return (double)count / cap;
+	return cap == 0 ? 0 : (double)count / cap;
 }
 
 template<typename V, typename H, typename C>
@@ -170,20 +391,549 @@ bool hashtable_oa<V, H, C>::empty() const {
 	return count == 0;
 }
 
+template<typename V, typename H, typename C>
+size_t hashtable_oa<V, H, C>::deleted_slots() const {
+	return count_control(ctrl.data(), 0, cap, 1);
+}
+
+template<typename V, typename H, typename C>
+double hashtable_oa<V, H, C>::mean_probe_length() const {
+	size_t stride = std::max<size_t>(cap / 1024, 1);
+	size_t samples = 0, probes = 0, last = cap;
+	for (size_t i = 0; i < cap; i += stride) {
+		size_t slot = find_control(ctrl.data(), i, cap, 2);
+		if (slot == cap) break;
+		if (slot == last) continue;
+		last = slot;
+		size_t home = guard(data[slot].value) % cap;
+		probes += (slot + cap - home) % cap + 1;
+		samples++;
+	}
+	return samples == 0 ? 0 : (double)probes / samples;
+}
+
 template<typename V, typename H, typename C>
 size_t hashtable_oa<V, H, C>::indexOf(const V& value) const {
-	size_t index = get_hash_index(value);
-	while (data.at(index).state > 0){
-		if(data.at(index).state == 2 && C()(data.at(index).value, value)){
-			return index;
+	size_t free, probes, deleted;
+	return probe(value, guard(value), free, probes, deleted);
+}
+
+//slot of value or -1, checks the Bloom filter first. Unlike contains() it leaves the cache
+//statistics and reference bits alone and may run on many threads
+template<typename V, typename H, typename C>
+size_t hashtable_oa<V, H, C>::find_slot(const V& value) const {
+	size_t hash = guard(value), free, probes, deleted;
+	if (filter.enabled() && !filter.may_contain(hash)) return -1; //rejected by the filter
+	return probe(value, hash, free, probes, deleted);
+}
+
+//walks the probe sequence of value and returns its slot or -1 if it is not stored.
+//free is set to the first deleted or empty slot of the sequence, where an insert puts the value.
+//probes counts the values and deleted the deleted slots on the way.
+//At most cap slots are visited, so a table full of deleted slots cannot loop forever
+template<typename V, typename H, typename C>
+size_t hashtable_oa<V, H, C>::probe(const V& value, size_t hash, size_t& free, size_t& probes, size_t& deleted) const {
+	free = -1;
+	probes = 0;
+	deleted = 0;
+	if (cap == 0) return -1; //moved from
+	size_t index = hash % cap;
+	for (size_t visited = 0; visited < cap; visited++) {
+		if (ctrl[index] == 0) {
+			if (free == (size_t)-1)
+				free = index;
+			return -1;
+		}
+		if (ctrl[index] == 1) {
+			deleted++;
+			if (free == (size_t)-1)
+				free = index;
+		} else {
+			probes++;
+			if (C()(data[index].value, value))
+				return index;
 		}
-		index++;		
-		if(index == cap)
+		index++;
+		if (index == cap)
 			index = 0;
 	}
 	return -1;
 }
 
+//insert without duplicate check for rehash, the new table has no deleted slots
+template<typename V, typename H, typename C>
+void hashtable_oa<V, H, C>::place(V&& value) {
+	size_t hash = guard(value);
+	size_t index = hash % cap;
+	while (ctrl[index] == 2) {
+		index++;
+		if (index == cap)
+			index = 0;
+	}
+	data[index].value = std::move(value);
+	ctrl[index] = 2;
+	data[index].referenced = 0;
+	count++;
+	if (filter.enabled())
+		filter.add(hash);
+}
+
+//first empty slot at or after index, cap if there is none
+template<typename V, typename H, typename C>
+size_t hashtable_oa<V, H, C>::next_empty(size_t index) const {
+	return find_control(ctrl.data(), index, cap, 0);
+}
+
+//recount of the values from the control bytes
+template<typename V, typename H, typename C>
+size_t hashtable_oa<V, H, C>::count_occupied(execution_policy policy) const {
+	std::vector<size_t> counts(chunk_count(policy), 0);
+	parallel_for(policy, cap, [&](size_t chunk, size_t first, size_t last) {
+		counts[chunk] = count_control(ctrl.data(), first, last, 2);
+	});
+	size_t n = 0;
+	for (size_t c : counts)
+		n += c;
+	return n;
+}
+
+//iterator at the first occupied slot at or after slot
+template<typename V, typename H, typename C>
+typename hashtable_oa<V, H, C>::const_iterator hashtable_oa<V, H, C>::iterator_at(size_t slot) const {
+	return const_iterator(&data, &ctrl, data.begin() + find_control(ctrl.data(), slot, cap, 2));
+}
+
+//moves the values between the empty slots start and end, possibly wrapping around, into the
+//first free slot of their probe sequence. No probe sequence crosses an empty slot, so
+//disjoint segments can be compacted concurrently
+template<typename V, typename H, typename C>
+void hashtable_oa<V, H, C>::compact(size_t start, size_t end) {
+	size_t index = start;
+	do {
+		index = index + 1 == cap ? 0 : index + 1;
+		if (ctrl[index] != 2) continue;
+
+		//values in front of index on the probe sequence are final -> take the first free slot
+		size_t target = guard(data[index].value) % cap;
+		while (target != index && ctrl[target] != 3)
+			target = target + 1 == cap ? 0 : target + 1;
+		if (target != index) {
+			data[target].value = std::move(data[index].value);
+			ctrl[target] = 2;
+			data[target].referenced = data[index].referenced;
+			ctrl[index] = 3;
+		}
+	} while (index != end);
+}
+
+template<typename V, typename H, typename C>
+void hashtable_oa<V, H, C>::inserted(size_t hash, size_t probes, size_t deleted) {
+	if (filter.enabled())
+		filter.add(hash);
+
+	count++;
+	if (guard.probe_too_long(probes, cap)) {
+		guard.escalate();
+		rehash(cap);
+	} else if (max_count == 0 && load_factor() > 0.75)
+		rehash(cap * 2);
+	else if (deleted > flood_guard<V, H, C>::probe_limit(cap))
+		rehash(cap); //erases left a long run of deleted slots, the hash function is not at fault
+}
+
+template<typename V, typename H, typename C>
+template<typename P>
+size_t hashtable_oa<V, H, C>::erase_if(P pred, execution_policy policy) {
+	//1. free the slots of the victims and the deleted slots. Empty slots stay 0: no probe
+	//sequence crosses them, so they split the table into independent segments
+	parallel_for(policy, cap, [&](size_t, size_t first, size_t last) {
+		for (size_t i = find_control_not(ctrl.data(), first, last, 0); i < last;
+			i = find_control_not(ctrl.data(), i + 1, last, 0)) {
+			if (ctrl[i] == 1 || pred(std::as_const(data[i].value)))
+				ctrl[i] = 3;
+		}
+	});
+	size_t erased = count;
+	count = count_occupied(policy);
+	erased -= count;
+
+	if (next_empty(0) == cap) {
+		//no empty slot -> no segment start, rebuild instead
+		rehash(cap);
+	} else {
+		//2. each chunk compacts the segments that start in its range. They end at the next empty slot,
+		//possibly in a later range, so all bounds are found before the moves rewrite control bytes
+		std::vector<std::pair<size_t, size_t>> segments(chunk_count(policy), { cap, cap });
+		parallel_for(policy, cap, [&](size_t chunk, size_t first, size_t last) {
+			size_t start = next_empty(first);
+			if (start >= last) return; //no segment starts here
+			size_t end = next_empty(last);
+			segments[chunk] = { start, end == cap ? next_empty(0) : end }; //the last segment wraps around
+		});
+		parallel_for(policy, cap, [&](size_t chunk, size_t, size_t) {
+			if (segments[chunk].first != cap)
+				compact(segments[chunk].first, segments[chunk].second);
+		});
+		//3. release the freed slots
+		parallel_for(policy, cap, [&](size_t, size_t first, size_t last) {
+			for (size_t i = find_control(ctrl.data(), first, last, 3); i < last;
+				i = find_control(ctrl.data(), i + 1, last, 3)) {
+				data[i].value = V();
+				ctrl[i] = 0;
+			}
+		});
+	}
+	filter_erased(erased);
+	return erased;
+}
+
+//slots are filled uniformly, so equal slot ranges hold roughly equal numbers of values
+template<typename V, typename H, typename C>
+std::vector<typename hashtable_oa<V, H, C>::partition> hashtable_oa<V, H, C>::partitions(size_t n) const {
+	if (n == 0) n = 1;
+	std::vector<partition> parts;
+	parts.reserve(n);
+	const_iterator first = begin();
+	for (size_t k = 1; k <= n; k++) {
+		const_iterator last = k == n ? end() : iterator_at(cap * k / n);
+		parts.push_back(partition(first, last));
+		first = last;
+	}
+	return parts;
+}
+
+template<typename V, typename H, typename C>
+template<typename F>
+void hashtable_oa<V, H, C>::for_each(execution_policy policy, F fn) const {
+	std::vector<partition> parts = partitions(chunk_count(policy));
+	parallel_for(policy, parts.size(), [&](size_t, size_t first, size_t last) {
+		for (size_t k = first; k < last; k++) {
+			for (const V& item : parts[k])
+				fn(item);
+		}
+	});
+}
+
+//=========  SET ALGEBRA  =============
+
+template<typename V, typename H, typename C>
+void hashtable_oa<V, H, C>::merge(const hashtable_oa& other) {
+	if (this == &other) return;
+
+	if (other.count > count && max_count == 0 && other.max_count == 0) {
+		//cheaper to copy the larger table and add the smaller one to it.
+		//Not for a bounded other: the copy would evict with its limit and callback
+		hashtable_oa result(other);
+		result.reserve(count + other.count);
+		for (size_t i = 0; i < cap; i++) {
+			if (ctrl[i] == 2)
+				result.insert(std::move(data[i].value));
+		}
+		data.swap(result.data);
+		ctrl.swap(result.ctrl);
+		count = result.count;
+		cap = result.cap;
+		guard = result.guard;
+		if (filter.enabled())
+			rebuild_filter();
+		return;
+	}
+
+	reserve(count + other.count);
+	for (size_t i = 0; i < other.cap; i++) {
+		if (other.ctrl[i] == 2)
+			insert(other.data[i].value);
+	}
+}
+
+template<typename V, typename H, typename C>
+void hashtable_oa<V, H, C>::merge(hashtable_oa&& other) {
+	if (this == &other) return;
+
+	bool plain = max_count == 0 && other.max_count == 0 && !filter.enabled() && !other.filter.enabled();
+	if (plain && other.count > count)
+		swap(other);
+
+	reserve(count + other.count);
+	for (size_t i = 0; i < other.cap; i++) {
+		if (other.ctrl[i] == 2)
+			insert(std::move(other.data[i].value));
+	}
+	other.clear();
+}
+
+template<typename V, typename H, typename C>
+void hashtable_oa<V, H, C>::intersect(const hashtable_oa& other, execution_policy policy) {
+	if (this == &other) return;
+
+	if (other.count < count) {
+		//probe the smaller table and rebuild this one from the matches
+		std::vector<size_t> kept;
+		for (size_t i = 0; i < other.cap; i++) {
+			if (other.ctrl[i] == 2) {
+				size_t index = indexOf(other.data[i].value);
+				if (index != (size_t)-1)
+					kept.push_back(index);
+			}
+		}
+		entry_vector old_data(cap, { V{}, 0 });
+		old_data.swap(data);
+		std::memset(ctrl.data(), 0, cap);
+		size_t old_count = count;
+		count = 0;
+		for (size_t index : kept)
+			insert(std::move(old_data[index].value));
+		filter_erased(old_count - count);
+		return;
+	}
+
+	erase_matching(other, false, policy);
+}
+
+template<typename V, typename H, typename C>
+void hashtable_oa<V, H, C>::difference(const hashtable_oa& other, execution_policy policy) {
+	if (this == &other) {
+		clear();
+		return;
+	}
+
+	if (other.count < count) {
+		//probe the smaller table and erase its values from this one
+		for (size_t i = 0; i < other.cap; i++) {
+			if (other.ctrl[i] == 2)
+				erase(other.data[i].value);
+		}
+		return;
+	}
+
+	erase_matching(other, true, policy);
+}
+
+//erases the values that other contains (in_other) or lacks (!in_other), looking them up with policy
+template<typename V, typename H, typename C>
+void hashtable_oa<V, H, C>::erase_matching(const hashtable_oa& other, bool in_other, execution_policy policy) {
+	if (max_count == 0) {
+		std::vector<size_t> removed(chunk_count(policy), 0);
+		parallel_for(policy, cap, [&](size_t chunk, size_t first, size_t last) {
+			for (size_t i = first; i < last; i++) {
+				if (ctrl[i] == 2 && (other.find_slot(data[i].value) != (size_t)-1) == in_other) {
+					ctrl[i] = 1;
+					removed[chunk]++;
+				}
+			}
+		});
+		for (size_t n : removed) {
+			count -= n;
+			filter_erased(n);
+		}
+		return;
+	}
+
+	//a cache must not collect deleted slots: the victims are looked up in parallel, then removed by
+	//backward shifts. A shift only moves values of the run after its index, so taking the victims
+	//cyclically downwards from an empty slot leaves the indices still to remove in place
+	std::vector<std::vector<size_t>> victims(chunk_count(policy));
+	parallel_for(policy, cap, [&](size_t chunk, size_t first, size_t last) {
+		for (size_t i = first; i < last; i++) {
+			if (ctrl[i] == 2 && (other.find_slot(data[i].value) != (size_t)-1) == in_other)
+				victims[chunk].push_back(i);
+		}
+	});
+	std::vector<size_t> indices;
+	for (const std::vector<size_t>& chunk : victims)
+		indices.insert(indices.end(), chunk.begin(), chunk.end());
+	size_t empty = next_empty(0); //a cache always has one
+	auto split = std::lower_bound(indices.begin(), indices.end(), empty);
+	for (auto it = split; it != indices.begin(); )
+		remove_at(*--it);
+	for (auto it = indices.end(); it != split; )
+		remove_at(*--it);
+}
+
+template<typename V, typename H, typename C>
+bool hashtable_oa<V, H, C>::is_subset(const hashtable_oa& other, execution_policy policy) const {
+	if (count > other.count) return false;
+
+	std::atomic<bool> subset(true);
+	parallel_for(policy, cap, [&](size_t, size_t first, size_t last) {
+		for (size_t i = first; i < last && subset.load(std::memory_order_relaxed); i++) {
+			if (ctrl[i] == 2 && other.find_slot(data[i].value) == (size_t)-1)
+				subset = false;
+		}
+	});
+	return subset;
+}
+
+template<typename V, typename H, typename C>
+bool hashtable_oa<V, H, C>::equals(const hashtable_oa& other, execution_policy policy) const {
+	return count == other.count && is_subset(other, policy);
+}
+
+template<typename V, typename H, typename C>
+void hashtable_oa<V, H, C>::reserve(size_t n) {
+	if (max_count != 0) return; //a cache evicts instead of growing
+	size_t new_cap = std::max<size_t>(cap, 1);
+	while ((double)n / new_cap > 0.75)
+		new_cap *= 2;
+	if (new_cap != cap)
+		rehash(new_cap);
+}
+
+//=========  BLOOM FILTER  =============
+
+template<typename V, typename H, typename C>
+void hashtable_oa<V, H, C>::enable_bloom_filter(double fp_rate, size_t max_bytes) {
+	filter_fp_rate = fp_rate;
+	filter_max_bytes = max_bytes;
+	rebuild_filter();
+}
+
+template<typename V, typename H, typename C>
+void hashtable_oa<V, H, C>::disable_bloom_filter() {
+	filter = blocked_bloom_filter();
+	filter_stale = 0;
+}
+
+template<typename V, typename H, typename C>
+void hashtable_oa<V, H, C>::rebuild_filter() {
+	//dimensioned for the largest size before the next rehash
+	filter = blocked_bloom_filter(std::max(cap * 3 / 4, count), filter_fp_rate, filter_max_bytes);
+	for (size_t i = 0; i < cap; i++) {
+		if (ctrl[i] == 2)
+			filter.add(guard(data[i].value));
+	}
+	filter_stale = 0;
+}
+
+template<typename V, typename H, typename C>
+void hashtable_oa<V, H, C>::filter_erased(size_t n) {
+	if (!filter.enabled()) return;
+	//stale bits raise the false positive rate, rebuild once they reach a quarter of the dimensioned size
+	filter_stale += n;
+	if (filter_stale * 4 > std::max(cap * 3 / 4, count))
+		rebuild_filter();
+}
+
+//=========  CACHE MODE  =============
+
+template<typename V, typename H, typename C>
+void hashtable_oa<V, H, C>::enable_cache(size_t max_size) {
+	max_count = std::max<size_t>(max_size, 1);
+	//shrinking: evict the surplus before the slot array gets its final size
+	while (count > max_count) {
+		size_t victim = clock_victim();
+		if (evict_callback)
+			evict_callback(std::move(data[victim].value));
+		data[victim].value = V();
+		ctrl[victim] = 1;
+		count--;
+		evicted++;
+	}
+	rehash(cache_slots(max_count)); //also drops the deleted slots
+	hand = 0;
+}
+
+template<typename V, typename H, typename C>
+void hashtable_oa<V, H, C>::enable_cache_bytes(size_t bytes) {
+	size_t slots = bytes / sizeof(Entry);
+	enable_cache(slots > 1 ? (slots - 1) * 3 / 4 : 1);
+}
+
+template<typename V, typename H, typename C>
+void hashtable_oa<V, H, C>::disable_cache() {
+	max_count = 0;
+}
+
+template<typename V, typename H, typename C>
+void hashtable_oa<V, H, C>::on_evict(std::function<void(V&&)> fn) {
+	evict_callback = fn;
+}
+
+template<typename V, typename H, typename C>
+size_t hashtable_oa<V, H, C>::max_size() const {
+	return max_count;
+}
+
+template<typename V, typename H, typename C>
+size_t hashtable_oa<V, H, C>::cache_hits() const {
+	return hits;
+}
+
+template<typename V, typename H, typename C>
+size_t hashtable_oa<V, H, C>::cache_misses() const {
+	return misses;
+}
+
+template<typename V, typename H, typename C>
+size_t hashtable_oa<V, H, C>::cache_evictions() const {
+	return evicted;
+}
+
+//slots of a cache that holds max_size values at load factor 0.75
+template<typename V, typename H, typename C>
+size_t hashtable_oa<V, H, C>::cache_slots(size_t max_size) {
+	return max_size + max_size / 3 + 1;
+}
+
+//advances the hand to the first value without reference bit and clears the bits it passes.
+//Terminates after at most one round because the first round clears every bit
+template<typename V, typename H, typename C>
+size_t hashtable_oa<V, H, C>::clock_victim() {
+	while (true) {
+		if (hand >= cap)
+			hand = 0;
+		Entry& entry = data[hand];
+		if (ctrl[hand] == 2) {
+			if (!entry.referenced)
+				return hand;
+			entry.referenced = 0;
+		}
+		hand++;
+	}
+}
+
+template<typename V, typename H, typename C>
+void hashtable_oa<V, H, C>::evict() {
+	size_t victim = clock_victim();
+	if (evict_callback)
+		evict_callback(std::move(data[victim].value));
+	remove_at(victim);
+	evicted++;
+}
+
+//erases the value at index without leaving a deleted slot (backward shift deletion):
+//the following values of the run that may use the gap move back, so lookups never
+//walk over it. A value moved into the gap behind the clock hand keeps its reference bit
+template<typename V, typename H, typename C>
+void hashtable_oa<V, H, C>::remove_at(size_t index) {
+	size_t gap = index;
+	bool closed = false;
+	for (size_t steps = 1; steps < cap; steps++) {
+		index = index + 1 == cap ? 0 : index + 1;
+		Entry& entry = data[index];
+		if (ctrl[index] == 0) {
+			closed = true;
+			break;
+		}
+		if (ctrl[index] != 2) continue; //deleted slot, passed by lookups anyway
+
+		//the value stays if its home slot lies cyclically in (gap, index]
+		size_t home = guard(entry.value) % cap;
+		bool stays = gap <= index ? gap < home && home <= index : gap < home || home <= index;
+		if (!stays) {
+			data[gap].value = std::move(entry.value);
+			ctrl[gap] = 2;
+			data[gap].referenced = entry.referenced;
+			gap = index;
+		}
+	}
+	data[gap].value = V();
+	ctrl[gap] = closed ? 0 : 1; //without empty slot the run covers the table, keep it unbroken
+	data[gap].referenced = 0;
+	count--;
+	filter_erased(1);
+}
+
 //==========  DEFINITION OF ITERATOR CLASS ==============
 
 
@@ -191,31 +941,46 @@ template<typename V, typename H, typename C>
 class hashtable_oa<V, H, C>::const_iterator : public iterator_base {
 
 	private:
-		typename std::vector<Entry>::const_iterator data_iterator; // Iterator of data vector for accessing entries
-		typename const typename std::vector<Entry>* data_ptr; //pointer to data vector for comparisons
+		typename entry_vector::const_iterator data_iterator; // Iterator of data vector for accessing entries
+		const entry_vector* data_ptr; //pointer to data vector for comparisons
+		const control_vector* ctrl_ptr; //states of the slots, scanned for the next occupied one
+
+		size_t slot() const {
+			return data_iterator - data_ptr->begin();
+		}
+
+		//first occupied slot at or after slot, end() if there is none
+		void seek(size_t slot) {
+			data_iterator = data_ptr->begin() + find_control(ctrl_ptr->data(), slot, ctrl_ptr->size(), 2);
+		}
+
+		//the occupied slot before the current one, begin of the data if there is none
+		void seek_back() {
+			size_t i = slot();
+			do {
+				i--;
+			} while (i != 0 && (*ctrl_ptr)[i] != 2);
+			data_iterator = data_ptr->begin() + i;
+		}
 
 	public:
 
-		const_iterator(	const typename std::vector<Entry>* data,
-										const typename std::vector<Entry>::const_iterator data_it)
-										: data_iterator(data_it), data_ptr(data) {		
+		const_iterator(	const entry_vector* data,
+										const control_vector* ctrl,
+										const typename entry_vector::const_iterator data_it)
+										: data_iterator(data_it), data_ptr(data), ctrl_ptr(ctrl) {		
 			if(data_iterator == data_ptr->begin()){//begin() called -> find first element
-				while(data_iterator != data_ptr->end() && data_iterator->state != 2 )
-					data_iterator++;
+				seek(0);
 			} 
 			//no action needed for end()
 		}
 
-		typename std::vector<Entry>::const_iterator get_data_iterator() const {
+		typename entry_vector::const_iterator get_data_iterator() const {
 			return data_iterator;
 		}
 
 		bool hasNext(){			
-			auto data_iterator_copy = data_iterator;
-			while(data_iterator_copy != data_ptr->end() && data_iterator_copy->state < 2){
-				data_iterator_copy++;
-			}
-			return data_iterator_copy != data_ptr->end();
+			return find_control(ctrl_ptr->data(), slot(), ctrl_ptr->size(), 2) != ctrl_ptr->size();
 		}
 
 		bool operator==(const_iterator const& rhs) const {
@@ -232,56 +997,59 @@ class hashtable_oa<V, H, C>::const_iterator : public iterator_base {
 
 		const_iterator& operator++() {
 			if(data_iterator != data_ptr->end()){
-				do{
-					data_iterator++;
-				} while(data_iterator != data_ptr->end() && data_iterator->state != 2);		
+				seek(slot() + 1);
 			}
 			return *this;
 		}
 
 		const_iterator& operator--() {
 			if (data_iterator != data_ptr->begin()) {
-				do {
-					data_iterator--;
-				} while (data_iterator != data_ptr->begin() && data_iterator->state != 2);
+				seek_back();
 			}			
 			return *this;
 		}
 
 		const_iterator operator++(int) {
 			const_iterator temp = *this; // Preserve state because of post-increment
-			if (data_iterator != data_ptr->end()) {
-				do {
-					data_iterator++;
-				} while (data_iterator != data_ptr->end() && data_iterator->state != 2);
-			}
+			++(*this);
 			return temp;
 		}
 
 		const_iterator operator--(int) {
 			const_iterator temp = *this; //preserve state because post increment
-			//update state
-			if (data_iterator != data_ptr->begin()) {
-				do {
-					data_iterator--;
-				} while (data_iterator != data_ptr->begin() && data_iterator->state != 2);
-			}
+			--(*this);
 			return temp;
 		}
 };
 
 template<typename V, typename H, typename C>
-bool operator==(const hashtable_oa<V, H, C> lhs, const hashtable_oa<V, H, C> rhs) {
-	if (lhs.size() != rhs.size()) return false;
+bool operator==(const hashtable_oa<V, H, C>& lhs, const hashtable_oa<V, H, C>& rhs) {
+	return lhs.equals(rhs);
+}
 
-	auto iter_lhs = lhs.begin();
-	auto iter_rhs = rhs.begin();
+//==========  DEFINITION OF PARTITION CLASS ==============
 
-	while (iter_lhs != lhs.end()) {
-		if (!(C()(*iter_lhs, *iter_rhs))) return false;
-		iter_lhs++;
-		iter_rhs++;
-	}
 
-	return true;
-}
\ No newline at end of file
+template<typename V, typename H, typename C>
+class hashtable_oa<V, H, C>::partition {
+
+	private:
+		const_iterator first;
+		const_iterator last;
+
+	public:
+
+		partition(const_iterator first, const_iterator last) : first(first), last(last) {}
+
+		const_iterator begin() const {
+			return first;
+		}
+
+		const_iterator end() const {
+			return last;
+		}
+
+		bool empty() const {
+			return first == last;
+		}
+};
@@ -0,0 +1,315 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <ostream>
+#include <type_traits>
+#include <vector>
+#include "aligned_allocator.h"
+#include "hash.h"
+#include "hashtable.h"
+
+
+
+//open addressing for integral keys without per-slot state. Two key values are reserved as
+//sentinels: EMPTY marks a free slot, DELETED a tombstone. A slot is only the key itself,
+//so an int table fits 16 slots into a cache line and a probe compares keys directly.
+//With DELETED == EMPTY erase shifts the following entries back instead of leaving tombstones.
+//The sentinel values themselves cannot be stored: insert ignores them, contains returns false
+template<	typename K,
+					K EMPTY = std::numeric_limits<K>::max(),
+					K DELETED = EMPTY - 1,
+					typename H = default_hash<K>>
+class hashtable_oa_int : hashtable<K, H, std::equal_to<K>> {
+	static_assert(std::is_integral<K>::value, "hashtable_oa_int needs an integral key type");
+
+	public:
+
+		hashtable_oa_int(size_t capacity) {
+			cap = slot_count_for(capacity);
+			data = slot_vector(cap, EMPTY);
+			count = 0;
+			deleted = 0;
+		}
+
+		~hashtable_oa_int() {}
+		void insert(const K& value)override;
+		void erase(const K& value)override;
+		bool contains(const K& value) const override;
+		void rehash(size_t new_n_buckets)override;
+		void clear()override;
+
+		double load_factor() const override;
+		size_t size() const override;
+		size_t capacity() const override;
+		bool empty() const override;
+
+		friend std::ostream& operator<<(std::ostream& os, const hashtable_oa_int& ht) {
+			for (K key : ht)
+				os << key << " ";
+			os << "\n";
+			return os;
+		}
+
+		class const_iterator;
+
+		const_iterator begin() const {
+			return const_iterator(&data, 0);
+		}
+
+		const_iterator end() const {
+			return const_iterator(&data, cap);
+		}
+
+		using iterator_category = std::bidirectional_iterator_tag;
+		using value_type = K const;
+		using difference_type = std::ptrdiff_t;
+		using const_pointer = K const*;
+		using const_reference = K const&;
+
+		typedef std::iterator<std::bidirectional_iterator_tag, value_type, difference_type, const_pointer,
+			const_reference> iterator_base;
+
+	private:
+		typedef std::vector<K, huge_page_allocator<K>> slot_vector;
+
+		slot_vector data;
+		size_t count;
+		size_t deleted; //tombstones, always 0 with DELETED == EMPTY
+		size_t cap; //always a power of two
+
+		static bool is_sentinel(K key);
+		static size_t slot_count_for(size_t capacity);
+		size_t home_of(K key) const;
+		size_t indexOf(K key) const;
+		void shift_back(size_t index);
+};
+
+//=========  PUBLIC FUNCITONS  =============
+
+template<typename K, K EMPTY, K DELETED, typename H>
+void hashtable_oa_int<K, EMPTY, DELETED, H>::insert(const K& value) {
+	if (is_sentinel(value) || contains(value)) return;
+
+	size_t index = home_of(value);
+	while (data[index] != EMPTY && data[index] != DELETED)
+		index = (index + 1) & (cap - 1);
+	if (EMPTY != DELETED && data[index] == DELETED)
+		deleted--;
+	data[index] = value;
+
+	count++;
+	//tombstones lengthen probe sequences like keys
+	if ((double)(count + deleted) / cap > 0.75)
+		rehash(count * 2 > cap ? cap * 2 : cap);
+}
+
+template<typename K, K EMPTY, K DELETED, typename H>
+void hashtable_oa_int<K, EMPTY, DELETED, H>::erase(const K& value) {
+	if (is_sentinel(value)) return;
+
+	size_t index = indexOf(value);
+	if (index == (size_t)-1) return;
+
+	if (EMPTY == DELETED) {
+		shift_back(index);
+	} else {
+		data[index] = DELETED;
+		deleted++;
+	}
+	count--;
+}
+
+template<typename K, K EMPTY, K DELETED, typename H>
+bool hashtable_oa_int<K, EMPTY, DELETED, H>::contains(const K& value) const {
+	return !is_sentinel(value) && indexOf(value) != (size_t)-1;
+}
+
+template<typename K, K EMPTY, K DELETED, typename H>
+void hashtable_oa_int<K, EMPTY, DELETED, H>::rehash(size_t new_n_buckets) {
+	slot_vector old_data(slot_count_for(std::max(new_n_buckets, count)), EMPTY);
+	old_data.swap(data);
+	cap = data.size();
+	deleted = 0;
+
+	for (K key : old_data) {
+		if (is_sentinel(key)) continue;
+		size_t index = home_of(key);
+		while (data[index] != EMPTY)
+			index = (index + 1) & (cap - 1);
+		data[index] = key;
+	}
+}
+
+template<typename K, K EMPTY, K DELETED, typename H>
+void hashtable_oa_int<K, EMPTY, DELETED, H>::clear() {
+	std::fill(data.begin(), data.end(), EMPTY);
+	count = 0;
+	deleted = 0;
+}
+
+template<typename K, K EMPTY, K DELETED, typename H>
+double hashtable_oa_int<K, EMPTY, DELETED, H>::load_factor() const {
+	return (double)count / cap;
+}
+
+template<typename K, K EMPTY, K DELETED, typename H>
+size_t hashtable_oa_int<K, EMPTY, DELETED, H>::size() const {
+	return count;
+}
+
+template<typename K, K EMPTY, K DELETED, typename H>
+size_t hashtable_oa_int<K, EMPTY, DELETED, H>::capacity() const {
+	return cap;
+}
+
+template<typename K, K EMPTY, K DELETED, typename H>
+bool hashtable_oa_int<K, EMPTY, DELETED, H>::empty() const {
+	return count == 0;
+}
+
+//=========  PRIVATE FUNCITONS  =============
+
+template<typename K, K EMPTY, K DELETED, typename H>
+bool hashtable_oa_int<K, EMPTY, DELETED, H>::is_sentinel(K key) {
+	return key == EMPTY || key == DELETED;
+}
+
+template<typename K, K EMPTY, K DELETED, typename H>
+size_t hashtable_oa_int<K, EMPTY, DELETED, H>::slot_count_for(size_t capacity) {
+	size_t n = 16;
+	while (n < capacity)
+		n *= 2;
+	return n;
+}
+
+template<typename K, K EMPTY, K DELETED, typename H>
+size_t hashtable_oa_int<K, EMPTY, DELETED, H>::home_of(K key) const {
+	return (size_t)mixed_hash<H>(key) & (cap - 1);
+}
+
+template<typename K, K EMPTY, K DELETED, typename H>
+size_t hashtable_oa_int<K, EMPTY, DELETED, H>::indexOf(K key) const {
+	size_t index = home_of(key);
+	while (data[index] != EMPTY) {
+		if (data[index] == key)
+			return index;
+		index = (index + 1) & (cap - 1);
+	}
+	return -1;
+}
+
+//backward shift deletion: moves every following key of the probe run that may live
+//at or before the freed slot into it, so no tombstone is needed
+template<typename K, K EMPTY, K DELETED, typename H>
+void hashtable_oa_int<K, EMPTY, DELETED, H>::shift_back(size_t index) {
+	size_t next = index;
+	while (true) {
+		next = (next + 1) & (cap - 1);
+		if (data[next] == EMPTY) break;
+
+		size_t home = home_of(data[next]);
+		//the key stays if its home lies cyclically in (index, next]
+		bool stays = index <= next ? (index < home && home <= next) : (index < home || home <= next);
+		if (!stays) {
+			data[index] = data[next];
+			index = next;
+		}
+	}
+	data[index] = EMPTY;
+}
+
+//==========  DEFINITION OF ITERATOR CLASS ==============
+
+
+template<typename K, K EMPTY, K DELETED, typename H>
+class hashtable_oa_int<K, EMPTY, DELETED, H>::const_iterator : public iterator_base {
+
+	private:
+		const slot_vector* data_ptr; //pointer to data vector for accessing slots
+		size_t position; //slot index
+
+		bool occupied(size_t pos) const {
+			return !is_sentinel((*data_ptr)[pos]);
+		}
+
+	public:
+
+		const_iterator(const slot_vector* data, size_t position)
+										: data_ptr(data), position(position) {
+			if (position == 0) {//begin() called -> find first element
+				while (this->position != data_ptr->size() && !occupied(this->position))
+					this->position++;
+			}
+			//no action needed for end()
+		}
+
+		size_t get_position() const {
+			return position;
+		}
+
+		bool hasNext() {
+			size_t next = position;
+			while (next != data_ptr->size() && !occupied(next))
+				next++;
+			return next != data_ptr->size();
+		}
+
+		bool operator==(const_iterator const& rhs) const {
+			return position == rhs.get_position();
+		}
+
+		bool operator!=(const_iterator const& rhs) const {
+			return position != rhs.get_position();
+		}
+
+		const_reference operator*() const {
+			return (*data_ptr)[position];
+		}
+
+		const_pointer operator->() const {
+			return &(*data_ptr)[position];
+		}
+
+		const_iterator& operator++() {
+			if (position != data_ptr->size()) {
+				do {
+					position++;
+				} while (position != data_ptr->size() && !occupied(position));
+			}
+			return *this;
+		}
+
+		const_iterator& operator--() {
+			if (position != 0) {
+				do {
+					position--;
+				} while (position != 0 && !occupied(position));
+			}
+			return *this;
+		}
+
+		const_iterator operator++(int) {
+			const_iterator temp = *this; // Preserve state because of post-increment
+			++(*this);
+			return temp;
+		}
+
+		const_iterator operator--(int) {
+			const_iterator temp = *this; //preserve state because post increment
+			--(*this);
+			return temp;
+		}
+};
+
+template<typename K, K EMPTY, K DELETED, typename H>
+bool operator==(const hashtable_oa_int<K, EMPTY, DELETED, H>& lhs, const hashtable_oa_int<K, EMPTY, DELETED, H>& rhs) {
+	if (lhs.size() != rhs.size()) return false;
+
+	for (K key : lhs) {
+		if (!rhs.contains(key)) return false;
+	}
+	return true;
+}
@@ -0,0 +1,468 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <ostream>
+#include <utility>
+#include <vector>
+#include "hash.h"
+
+
+
+//persistent (immutable) set, a hash array mapped trie in the compact CHAMP layout.
+//Every node splits the values by 5 bits of their hash into 32 branches, a bitmap tells which
+//branches hold a value inline and which a child node. insert and erase return a new version that
+//copies the path to the changed node and shares all other nodes with the old version, so copying
+//a set (a snapshot) is O(1) and old versions stay valid and unchanged.
+//Nodes are reference counted with std::shared_ptr, different threads may read and update
+//their own copies of a set concurrently.
+//builder is the transient form for bulk edits: it changes the nodes it created in place
+//and only copies the nodes it shares with persistent versions
+template<	typename V,
+					typename H = default_hash<V>,
+					typename C = std::equal_to<V>>
+class hashtable_persistent {
+
+	private:
+		struct node;
+		typedef std::shared_ptr<node> node_ptr;
+
+	public:
+		hashtable_persistent() : root(nullptr), count(0) {}
+
+		//new versions, this set is not changed
+		hashtable_persistent insert(const V& value) const;
+		hashtable_persistent erase(const V& value) const;
+
+		bool contains(const V& value) const;
+		size_t size() const;
+		bool empty() const;
+
+		//same values. Versions that share subtrees skip them without looking at their values
+		bool operator==(const hashtable_persistent& other) const;
+		bool operator!=(const hashtable_persistent& other) const;
+
+		class builder;
+		builder transient() const;
+
+		friend std::ostream& operator<<(std::ostream& os, const hashtable_persistent<V, H, C>& ht) {
+			for (const V& item : ht)
+				os << item << " ";
+			os << "\n";
+			return os;
+		}
+
+		class const_iterator;
+
+		const_iterator begin() const {
+			return const_iterator(root.get());
+		}
+
+		const_iterator end() const {
+			return const_iterator(nullptr);
+		}
+
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = V const;
+		using difference_type = std::ptrdiff_t;
+		using const_pointer = V const*;
+		using const_reference = V const&;
+
+		typedef std::iterator<std::forward_iterator_tag, value_type, difference_type, const_pointer,
+			const_reference> iterator_base;
+
+	private:
+		static const unsigned BITS = 5; //hash bits per level -> 32 branches
+		static const unsigned HASH_BITS = sizeof(size_t) * 8; //below, all hash bits are used up
+
+		//values and children are ordered by their branch. Below HASH_BITS the node is a collision
+		//node: the values have equal hashes, both maps are unused and the values are unordered.
+		//edit is the builder that may change the node in place, 0 for nodes of persistent versions
+		struct node {
+			uint32_t valuemap;
+			uint32_t childmap;
+			uint64_t edit;
+			std::vector<V> values;
+			std::vector<node_ptr> children;
+
+			explicit node(uint64_t edit) : valuemap(0), childmap(0), edit(edit) {}
+		};
+
+		node_ptr root; //null for the empty set
+		size_t count;
+
+		hashtable_persistent(node_ptr root, size_t count) : root(std::move(root)), count(count) {}
+
+		static size_t hash_of(const V& value);
+		static uint32_t branch(size_t hash, unsigned shift);
+		static size_t index_of(uint32_t map, uint32_t bit);
+		static uint64_t next_edit();
+
+		static bool find(const node* n, const V& value, size_t hash);
+		static node_ptr editable(const node_ptr& n, uint64_t edit);
+		static node_ptr pair_node(const V& a, size_t hash_a, const V& b, size_t hash_b, unsigned shift, uint64_t edit);
+		static void insert_into(node* n, const V& value, size_t hash, unsigned shift, uint64_t edit);
+		static void erase_from(node* n, const V& value, size_t hash, unsigned shift, uint64_t edit);
+		static bool subset(const node* a, const node* b, const node* b_root, unsigned shift);
+};
+
+//=========  PUBLIC FUNCITONS  =============
+
+template<	typename V, typename H, typename C>
+hashtable_persistent<V, H, C> hashtable_persistent<V, H, C>::insert(const V& value) const {
+	size_t hash = hash_of(value);
+	if (find(root.get(), value, hash))
+		return *this;
+	node_ptr copy = root ? editable(root, 0) : std::make_shared<node>(0);
+	insert_into(copy.get(), value, hash, 0, 0);
+	return hashtable_persistent(copy, count + 1);
+}
+
+template<	typename V, typename H, typename C>
+hashtable_persistent<V, H, C> hashtable_persistent<V, H, C>::erase(const V& value) const {
+	size_t hash = hash_of(value);
+	if (!find(root.get(), value, hash))
+		return *this;
+	if (count == 1)
+		return hashtable_persistent();
+	node_ptr copy = editable(root, 0);
+	erase_from(copy.get(), value, hash, 0, 0);
+	return hashtable_persistent(copy, count - 1);
+}
+
+template<	typename V, typename H, typename C>
+bool hashtable_persistent<V, H, C>::contains(const V& value) const {
+	return find(root.get(), value, hash_of(value));
+}
+
+template<typename V, typename H, typename C>
+size_t hashtable_persistent<V, H, C>::size() const {
+	return count;
+}
+
+template<typename V, typename H, typename C>
+bool hashtable_persistent<V, H, C>::empty() const {
+	return count == 0;
+}
+
+template<typename V, typename H, typename C>
+bool hashtable_persistent<V, H, C>::operator==(const hashtable_persistent& other) const {
+	if (count != other.count) return false;
+	if (root == other.root) return true;
+	return subset(root.get(), other.root.get(), other.root.get(), 0);
+}
+
+template<typename V, typename H, typename C>
+bool hashtable_persistent<V, H, C>::operator!=(const hashtable_persistent& other) const {
+	return !(*this == other);
+}
+
+template<typename V, typename H, typename C>
+typename hashtable_persistent<V, H, C>::builder hashtable_persistent<V, H, C>::transient() const {
+	return builder(root, count);
+}
+
+//=========  PRIVATE FUNCITONS  =============
+
+template<typename V, typename H, typename C>
+size_t hashtable_persistent<V, H, C>::hash_of(const V& value) {
+	return H()(value);
+}
+
+template<typename V, typename H, typename C>
+uint32_t hashtable_persistent<V, H, C>::branch(size_t hash, unsigned shift) {
+	return (uint32_t)1 << ((hash >> shift) & 31);
+}
+
+//position of the entry for bit among the entries of map
+template<typename V, typename H, typename C>
+size_t hashtable_persistent<V, H, C>::index_of(uint32_t map, uint32_t bit) {
+	uint32_t x = map & (bit - 1);
+	x = x - ((x >> 1) & 0x55555555);
+	x = (x & 0x33333333) + ((x >> 2) & 0x33333333);
+	return (((x + (x >> 4)) & 0x0f0f0f0f) * 0x01010101) >> 24;
+}
+
+//every builder gets its own edit number, persistent() switches to a fresh one
+template<typename V, typename H, typename C>
+uint64_t hashtable_persistent<V, H, C>::next_edit() {
+	static std::atomic<uint64_t> edits(0);
+	return ++edits;
+}
+
+template<typename V, typename H, typename C>
+bool hashtable_persistent<V, H, C>::find(const node* n, const V& value, size_t hash) {
+	for (unsigned shift = 0; n != nullptr; shift += BITS) {
+		if (shift >= HASH_BITS) {
+			for (const V& item : n->values) {
+				if (C()(item, value)) return true;
+			}
+			return false;
+		}
+		uint32_t bit = branch(hash, shift);
+		if (n->valuemap & bit)
+			return C()(n->values[index_of(n->valuemap, bit)], value);
+		if (!(n->childmap & bit))
+			return false;
+		n = n->children[index_of(n->childmap, bit)].get();
+	}
+	return false;
+}
+
+//n itself if the builder edit created it, otherwise a copy owned by edit
+template<typename V, typename H, typename C>
+typename hashtable_persistent<V, H, C>::node_ptr hashtable_persistent<V, H, C>::editable(const node_ptr& n, uint64_t edit) {
+	if (edit != 0 && n->edit == edit)
+		return n;
+	node_ptr copy = std::make_shared<node>(*n);
+	copy->edit = edit;
+	return copy;
+}
+
+//node holding two values whose hashes agree in the bits above shift
+template<typename V, typename H, typename C>
+typename hashtable_persistent<V, H, C>::node_ptr hashtable_persistent<V, H, C>::pair_node(const V& a, size_t hash_a,
+	const V& b, size_t hash_b, unsigned shift, uint64_t edit) {
+	node_ptr n = std::make_shared<node>(edit);
+	if (shift >= HASH_BITS) {
+		n->values = { a, b };
+		return n;
+	}
+	uint32_t bit_a = branch(hash_a, shift), bit_b = branch(hash_b, shift);
+	if (bit_a == bit_b) {
+		n->childmap = bit_a;
+		n->children.push_back(pair_node(a, hash_a, b, hash_b, shift + BITS, edit));
+	} else {
+		n->valuemap = bit_a | bit_b;
+		n->values = bit_a < bit_b ? std::vector<V>{ a, b } : std::vector<V>{ b, a };
+	}
+	return n;
+}
+
+//adds a value that is not stored yet, n is editable
+template<typename V, typename H, typename C>
+void hashtable_persistent<V, H, C>::insert_into(node* n, const V& value, size_t hash, unsigned shift, uint64_t edit) {
+	while (true) {
+		if (shift >= HASH_BITS) {
+			n->values.push_back(value);
+			return;
+		}
+		uint32_t bit = branch(hash, shift);
+		if (n->valuemap & bit) {
+			//two values in one branch -> both move into a new child
+			size_t i = index_of(n->valuemap, bit);
+			node_ptr child = pair_node(n->values[i], hash_of(n->values[i]), value, hash, shift + BITS, edit);
+			n->values.erase(n->values.begin() + i);
+			n->valuemap ^= bit;
+			n->childmap |= bit;
+			n->children.insert(n->children.begin() + index_of(n->childmap, bit), child);
+			return;
+		}
+		if (n->childmap & bit) {
+			node_ptr& child = n->children[index_of(n->childmap, bit)];
+			child = editable(child, edit);
+			n = child.get();
+			shift += BITS;
+			continue;
+		}
+		n->valuemap |= bit;
+		n->values.insert(n->values.begin() + index_of(n->valuemap, bit), value);
+		return;
+	}
+}
+
+//removes a stored value, n is editable. A child left with a single value is replaced by the
+//value, so equal sets have equal shapes regardless of their history (up to collision nodes)
+template<typename V, typename H, typename C>
+void hashtable_persistent<V, H, C>::erase_from(node* n, const V& value, size_t hash, unsigned shift, uint64_t edit) {
+	if (shift >= HASH_BITS) {
+		for (size_t i = 0; i < n->values.size(); i++) {
+			if (C()(n->values[i], value)) {
+				n->values.erase(n->values.begin() + i);
+				return;
+			}
+		}
+		return;
+	}
+	uint32_t bit = branch(hash, shift);
+	if (n->valuemap & bit) {
+		n->values.erase(n->values.begin() + index_of(n->valuemap, bit));
+		n->valuemap ^= bit;
+		return;
+	}
+
+	size_t j = index_of(n->childmap, bit);
+	node_ptr& child = n->children[j];
+	child = editable(child, edit);
+	erase_from(child.get(), value, hash, shift + BITS, edit);
+	if (child->childmap == 0 && child->values.size() == 1) {
+		V last = std::move(child->values[0]);
+		n->children.erase(n->children.begin() + j);
+		n->childmap ^= bit;
+		n->valuemap |= bit;
+		n->values.insert(n->values.begin() + index_of(n->valuemap, bit), std::move(last));
+	}
+}
+
+//every value below a is stored in the set rooted at b_root. b is the node at the same
+//position in that set if it has one, then shared subtrees are recognized by their address
+template<typename V, typename H, typename C>
+bool hashtable_persistent<V, H, C>::subset(const node* a, const node* b, const node* b_root, unsigned shift) {
+	if (a == nullptr || a == b) return true;
+	for (const V& item : a->values) {
+		if (!find(b_root, item, hash_of(item))) return false;
+	}
+	for (size_t i = 0; i < a->children.size(); i++) {
+		const node* b_child = nullptr;
+		if (b != nullptr && shift < HASH_BITS) {
+			//the branch of the i-th child of a
+			uint32_t map = a->childmap;
+			for (size_t k = 0; k < i; k++)
+				map &= map - 1;
+			uint32_t bit = map & (0 - map);
+			if (b->childmap & bit)
+				b_child = b->children[index_of(b->childmap, bit)].get();
+		}
+		if (!subset(a->children[i].get(), b_child, b_root, shift + BITS)) return false;
+	}
+	return true;
+}
+
+//==========  DEFINITION OF BUILDER CLASS ==============
+
+//transient set for bulk edits, e.g. builder b = set.transient(); ... set = b.persistent();
+//The first change of a shared node copies it, later changes of the copy happen in place.
+//persistent() returns the current values as a persistent version in O(1)
+template<typename V, typename H, typename C>
+class hashtable_persistent<V, H, C>::builder {
+
+	public:
+		void insert(const V& value);
+		void erase(const V& value);
+		bool contains(const V& value) const;
+		size_t size() const;
+		bool empty() const;
+
+		//the builder stays usable, its next changes copy the nodes the version shares
+		hashtable_persistent persistent();
+
+	private:
+		friend class hashtable_persistent;
+
+		node_ptr root;
+		size_t count;
+		uint64_t edit;
+
+		builder(node_ptr root, size_t count) : root(std::move(root)), count(count), edit(next_edit()) {}
+};
+
+template<typename V, typename H, typename C>
+void hashtable_persistent<V, H, C>::builder::insert(const V& value) {
+	size_t hash = hash_of(value);
+	if (find(root.get(), value, hash))
+		return;
+	root = root ? editable(root, edit) : std::make_shared<node>(edit);
+	insert_into(root.get(), value, hash, 0, edit);
+	count++;
+}
+
+template<typename V, typename H, typename C>
+void hashtable_persistent<V, H, C>::builder::erase(const V& value) {
+	size_t hash = hash_of(value);
+	if (!find(root.get(), value, hash))
+		return;
+	if (--count == 0) {
+		root = nullptr;
+		return;
+	}
+	root = editable(root, edit);
+	erase_from(root.get(), value, hash, 0, edit);
+}
+
+template<typename V, typename H, typename C>
+bool hashtable_persistent<V, H, C>::builder::contains(const V& value) const {
+	return find(root.get(), value, hash_of(value));
+}
+
+template<typename V, typename H, typename C>
+size_t hashtable_persistent<V, H, C>::builder::size() const {
+	return count;
+}
+
+template<typename V, typename H, typename C>
+bool hashtable_persistent<V, H, C>::builder::empty() const {
+	return count == 0;
+}
+
+template<typename V, typename H, typename C>
+hashtable_persistent<V, H, C> hashtable_persistent<V, H, C>::builder::persistent() {
+	edit = next_edit(); //the nodes made so far now belong to the returned version
+	return hashtable_persistent(root, count);
+}
+
+//==========  DEFINITION OF ITERATOR CLASS ==============
+
+//depth first walk, the values of a node before its children
+template<typename V, typename H, typename C>
+class hashtable_persistent<V, H, C>::const_iterator : public iterator_base {
+
+	private:
+		//node and position: values first, then children
+		std::vector<std::pair<const node*, size_t>> path;
+
+		void settle() {
+			while (!path.empty()) {
+				std::pair<const node*, size_t>& top = path.back();
+				if (top.second < top.first->values.size())
+					return;
+				size_t child = top.second - top.first->values.size();
+				if (child < top.first->children.size()) {
+					top.second++;
+					path.push_back({ top.first->children[child].get(), 0 });
+				} else {
+					path.pop_back();
+				}
+			}
+		}
+
+	public:
+		explicit const_iterator(const node* root) {
+			if (root != nullptr) {
+				path.push_back({ root, 0 });
+				settle();
+			}
+		}
+
+		bool operator==(const const_iterator& rhs) const {
+			if (path.empty() || rhs.path.empty())
+				return path.empty() == rhs.path.empty();
+			return path.back() == rhs.path.back();
+		}
+
+		bool operator!=(const const_iterator& rhs) const {
+			return !(*this == rhs);
+		}
+
+		const V& operator*() const {
+			return path.back().first->values[path.back().second];
+		}
+
+		const V* operator->() const {
+			return &**this;
+		}
+
+		const_iterator& operator++() {
+			path.back().second++;
+			settle();
+			return *this;
+		}
+
+		const_iterator operator++(int) {
+			const_iterator temp = *this;
+			++(*this);
+			return temp;
+		}
+};
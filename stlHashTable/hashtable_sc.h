@@ -1,16 +1,34 @@
 #pragma once
 #include <algorithm>
+#include <atomic>
 #include <functional>
 #include <iterator>
 #include <list>
+#include <memory>
 #include <ostream>
+#include <set>
+#include <type_traits>
+#include <utility>
 #include <vector>
+#include "aligned_allocator.h"
+#include "bloom_filter.h"
+#include "flood_guard.h"
+#include "hash.h"
 #include "hashtable.h"
+#include "instrumentation.h"
+#include "parallel.h"
 
 
 
+//values that can be ordered with operator<, the trees of long chains use it after the hash
+template<typename V, typename Enable = void>
+struct has_less : std::false_type {};
+
+template<typename V>
+struct has_less<V, decltype((void)(std::declval<const V&>() < std::declval<const V&>()))> : std::true_type {};
+
 template<	typename V, 
-					typename H = std::hash<V>, 
+					typename H = default_hash<V>, 
 					typename C = std::equal_to<V>>
 class hashtable_sc : hashtable<V,H,C>{//sc-> separate chaining
 	public: 	
@@ -18,20 +36,123 @@ class hashtable_sc : hashtable<V,H,C>{//sc-> separate chaining
 		hashtable_sc(size_t capacity){
 			cap = capacity;
 			count = 0;
-			data = std::vector<std::list<V>>(cap);			
+			data = bucket_vector(cap);			
+			filter_fp_rate = 0;
+			filter_max_bytes = 0;
+			filter_stale = 0;
+			tree_count = 0;
+		}
+
+		//the trees point into the nodes of other and are built again for the copy
+		hashtable_sc(const hashtable_sc& other) : data(other.data), count(other.count), cap(other.cap), guard(other.guard),
+			filter(other.filter), filter_fp_rate(other.filter_fp_rate), filter_max_bytes(other.filter_max_bytes),
+			filter_stale(other.filter_stale) {
+#ifdef HASHTABLE_INSTRUMENTATION
+			instruments = other.instruments;
+#endif
+			rebuild_trees();
+		}
+
+		//the moved-from table is left empty without buckets, the next insert allocates them.
+		//Moves do not allocate, so a std::vector of tables moves them when it grows
+		hashtable_sc(hashtable_sc&& other) noexcept : count(0), cap(0), filter_fp_rate(0), filter_max_bytes(0),
+			filter_stale(0), tree_count(0) {
+			swap(other);
+		}
+
+		hashtable_sc& operator=(const hashtable_sc& other) {
+			if (this != &other) {
+				hashtable_sc copy(other);
+				swap(copy);
+#ifdef HASHTABLE_INSTRUMENTATION
+				instruments = other.instruments;
+#endif
+			}
+			return *this;
+		}
+
+		hashtable_sc& operator=(hashtable_sc&& other) noexcept {
+			if (this != &other) {
+				hashtable_sc moved(std::move(other));
+				swap(moved);
+			}
+			return *this;
 		}
 
 		~hashtable_sc(){}
 		void insert(const V& value)override; 
+		void insert(V&& value);
+		template<typename... Args>
+		void emplace(Args&&... args);
 		void erase(const V& value)override;
-		bool contains(const V& value)override;
+		bool contains(const V& value) const override;
 		void rehash(size_t new_n_buckets)override;
 		void clear();
+		void swap(hashtable_sc& other);
 	
 		double load_factor() const override;
 		size_t size() const override;
 		size_t capacity() const override;
 		bool empty() const override;
+		//mean number of nodes a successful lookup visits, read by hashtable_adaptive before a rehash
+		double mean_probe_length() const;
+
+		//set algebra. The smaller set is probed against the larger one,
+		//tables with equal capacity are compared bucket by bucket without rehashing
+		void merge(const hashtable_sc& other, execution_policy policy = seq);
+		void intersect(const hashtable_sc& other, execution_policy policy = seq);
+		void difference(const hashtable_sc& other, execution_policy policy = seq);
+		bool is_subset(const hashtable_sc& other, execution_policy policy = seq) const;
+		bool equals(const hashtable_sc& other, execution_policy policy = seq) const;
+
+		//erases every value with pred(value) == true and returns the number of erased values.
+		//One pass over the buckets, the nodes are unlinked in place. With par(n) pred is called concurrently
+		template<typename P>
+		size_t erase_if(P pred, execution_policy policy = seq);
+
+		//partitions(n) splits the buckets into n disjoint ranges with roughly equal numbers of values,
+		//some may be empty. The ranges can be scanned concurrently, also by OpenMP, TBB or std::execution
+		class partition;
+		std::vector<partition> partitions(size_t n) const;
+		//calls fn(value) for every value, with par(n) concurrently on n partitions
+		template<typename F>
+		void for_each(execution_policy policy, F fn) const;
+
+		//Bloom filter checked by contains() before the bucket is searched.
+		//Meant for tables where most lookups miss, rebuilt on rehash and after many erases
+		void enable_bloom_filter(double fp_rate = 0.01, size_t max_bytes = 0);
+		void disable_bloom_filter();
+
+		//collision flooding: the table escalates from H to seeded and keyed hashing when a chain
+		//grows beyond flood_guard::MAX_CHAIN. reseed() switches to seeded hashing right away
+		void reseed();
+		typename flood_guard<V, H, C>::mode_type hash_mode() const;
+
+		//a chain longer than TREEIFY_THRESHOLD gets a tree over its nodes, ordered by hash and then by
+		//operator< if V has one and C is std::equal_to. Lookups in it take O(log n) even when every value
+		//has the same hash, e.g. for types flood_guard cannot key. Below UNTREEIFY_THRESHOLD values
+		//the tree is dropped. The values stay in the chain, iterators and node handles are not affected
+		static const size_t TREEIFY_THRESHOLD = 8;
+		static const size_t UNTREEIFY_THRESHOLD = 6;
+		size_t treeified_buckets() const;
+
+#ifdef HASHTABLE_INSTRUMENTATION
+		//latency histograms and rehash callbacks of this table, see instrumentation.h.
+		//They stay with the table object, swap() and moves do not exchange them
+		table_stats& stats() const {
+			return instruments;
+		}
+#endif
+
+		//node handles move values between tables by splicing their list node,
+		//the value is neither copied nor reallocated.
+		//insert(node_handle&&) returns false for a duplicate, the node stays in the handle.
+		//merge(std::move(other)) takes every node of other whose value is not stored yet,
+		//the duplicates remain in other
+		class node_handle;
+		node_handle extract(const V& value);
+		bool insert(node_handle&& node);
+		void merge(hashtable_sc&& other);
 
 		friend std::ostream& operator<<(std::ostream& os, const hashtable_sc<V,H,C>& ht){
 			for (const std::list<V>& list : ht.data) {
@@ -65,62 +186,204 @@ class hashtable_sc : hashtable<V,H,C>{//sc-> separate chaining
 			const_reference> iterator_base;
 
 	private:
-		std::vector<std::list<V>> data; 
+		typedef std::vector<std::list<V>, huge_page_allocator<std::list<V>>> bucket_vector;
+
+		bucket_vector data; 
 		size_t count;
 		size_t cap;			
-		int get_hash_index(const V& value);
+		flood_guard<V, H, C> guard; //hash function in use, H unless a flood was detected
+		TABLE_STATS_MEMBER
+		int get_hash_index(const V& value) const;
+		const_iterator iterator_at(size_t bucket) const;
+		void reserve(size_t n);
+		void inserted(int index, size_t hash);
+
+		blocked_bloom_filter filter;
+		double filter_fp_rate;
+		size_t filter_max_bytes;
+		size_t filter_stale; //erased values whose bits are still set in the filter
+		void rebuild_filter();
+		void filter_erased(size_t n);
+		static bool list_contains(const std::list<V>& list, const V& value);
+
+		struct tree_entry {
+			size_t hash;
+			const V* value;
+			typename std::list<V>::iterator node;
+		};
+
+		static const bool ordered_values = has_less<V>::value && std::is_same<C, std::equal_to<V>>::value;
+
+		struct tree_order {
+			bool operator()(const tree_entry& a, const tree_entry& b) const {
+				if (a.hash != b.hash) return a.hash < b.hash;
+				if constexpr (ordered_values)
+					return *a.value < *b.value;
+				else
+					return false;
+			}
+		};
+
+		typedef std::multiset<tree_entry, tree_order> chain_tree;
+
+		std::vector<std::unique_ptr<chain_tree>> trees; //one per bucket, empty while no chain is treeified
+		size_t tree_count;
+		typename std::list<V>::const_iterator bucket_find(size_t index, size_t hash, const V& value) const;
+		bool bucket_contains(size_t index, size_t hash, const V& value) const;
+		bool bucket_contains(size_t index, const V& value) const;
+		void treeify(size_t index);
+		void untreeify(size_t index);
+		void rebuild_trees();
+		void untrack(size_t index, size_t hash, typename std::list<V>::const_iterator node);
 };
 
 //=========  PUBLIC FUNCITONS  =============
 
 template<	typename V, typename H, typename C>
 void hashtable_sc<V, H, C>::insert(const V& value){
-	if(!contains(value)){
-		int index = get_hash_index(value);
-		data.at(index).push_back(value);	
+	TABLE_TIMER(inserts);
+	if (cap == 0) rehash(1); //moved from
+	size_t hash = guard(value);
+	int index = hash % (int)cap;
+	if(!bucket_contains(index, hash, value)){
+		data[index].push_back(value);	
+		inserted(index, hash);
+	}
+}
+
+template<	typename V, typename H, typename C>
+void hashtable_sc<V, H, C>::insert(V&& value){
+	TABLE_TIMER(inserts);
+	if (cap == 0) rehash(1); //moved from
+	size_t hash = guard(value);
+	int index = hash % (int)cap;
+	if(!bucket_contains(index, hash, value)){
+		data[index].push_back(std::move(value));	
+		inserted(index, hash);
+	}
+}
 
-		count++;
-		if (load_factor() > 0.75) 
-			rehash(cap * 2);
+//the value is constructed in a node of its own list and spliced into the bucket,
+//so it is never copied or moved
+template<	typename V, typename H, typename C>
+template<typename... Args>
+void hashtable_sc<V, H, C>::emplace(Args&&... args){
+	TABLE_TIMER(inserts);
+	std::list<V> node;
+	node.emplace_back(std::forward<Args>(args)...);
+	if (cap == 0) rehash(1); //moved from
+	size_t hash = guard(node.front());
+	int index = hash % (int)cap;
+	if(!bucket_contains(index, hash, node.front())){
+		data[index].splice(data[index].end(), node);
+		inserted(index, hash);
 	}
 }
 
 template<	typename V, typename H, typename C>
 void hashtable_sc<V, H, C>::erase(const V& value) {
-	if(contains(value)) {
+	TABLE_TIMER(erases);
+	if (cap == 0) return; //moved from
+	size_t hash = guard(value);
+	int index = hash % (int)cap;
+	std::list<V>& list = data[index];
+	auto it = bucket_find(index, hash, value);
+	if(it != list.end()) {
+		untrack(index, hash, it);
 		count--;
-		data.at(get_hash_index(value)).remove_if([value](V& element) {
-			return C()(element, value);
-		});
+		list.erase(it);
+		filter_erased(1);
 	}
 }
 
 template<	typename V, typename H, typename C>
-bool hashtable_sc<V, H, C>::contains(const V& value) {
-	int index = get_hash_index(value);
-	if(data.at(index).empty()) return false; //list empty
+bool hashtable_sc<V, H, C>::contains(const V& value) const {
+	TABLE_TIMER(lookups);
+	if (cap == 0) return false; //moved from
+	size_t hash = guard(value);
+	if (filter.enabled() && !filter.may_contain(hash)) return false; //rejected by the filter
 
-	for (V item : data.at(index)) {		
-		if (C()(item, value)) return true; // value found
-	}
-	return false; //value not found
+	return bucket_contains(hash % (int)cap, hash, value);
 }
 
+//the nodes are spliced into the new buckets, no value is copied or moved
 template<	typename V, typename H, typename C>
 void hashtable_sc<V, H, C>::rehash(size_t new_n_buckets) {
-	auto old_data = data;
+	TABLE_REHASH_TIMER(cap, new_n_buckets, count);
+	bucket_vector old_data(new_n_buckets);
+	old_data.swap(data);
 	cap = new_n_buckets;
-	data = std::vector<std::list<V>>(cap);
-	for (auto list : old_data) {
-		for(const V& item : list){
-			data.at(get_hash_index(item)).push_back(item);
+	for (std::list<V>& list : old_data) {
+		while (!list.empty()) {
+			std::list<V>& bucket = data[get_hash_index(list.front())];
+			bucket.splice(bucket.end(), list, list.begin());
 		}
 	}	
+	if (filter.enabled())
+		rebuild_filter();
+	rebuild_trees();
+}
+
+template<	typename V, typename H, typename C>
+int hashtable_sc<V, H, C>::get_hash_index(const V& value) const {
+	return guard(value) % (int)cap;
 }
 
+//iterator at the first value of the first non-empty bucket at or after bucket
 template<	typename V, typename H, typename C>
-int hashtable_sc<V, H, C>::get_hash_index(const V& value) {
-	return H()(value) % (int)cap;
+typename hashtable_sc<V, H, C>::const_iterator hashtable_sc<V, H, C>::iterator_at(size_t bucket) const {
+	while (bucket < cap && data[bucket].empty())
+		bucket++;
+	if (bucket == cap)
+		return end();
+	return const_iterator(&data, data.begin() + bucket, data[bucket].begin());
+}
+
+template<	typename V, typename H, typename C>
+void hashtable_sc<V, H, C>::inserted(int index, size_t hash) {
+	if (filter.enabled())
+		filter.add(hash);
+
+	count++;
+	if (guard.chain_too_long(data[index].size())) {
+		guard.escalate();
+		rehash(cap);
+	} else if (load_factor() > 0.75) 
+		rehash(cap * 2);
+	else if (!trees.empty() && trees[index])
+		trees[index]->insert(tree_entry{ hash, &data[index].back(), std::prev(data[index].end()) });
+	else if (data[index].size() > TREEIFY_THRESHOLD)
+		treeify(index);
+}
+
+template<	typename V, typename H, typename C>
+void hashtable_sc<V, H, C>::swap(hashtable_sc& other) {
+	data.swap(other.data);
+	std::swap(count, other.count);
+	std::swap(cap, other.cap);
+	std::swap(guard, other.guard);
+	std::swap(filter, other.filter);
+	std::swap(filter_fp_rate, other.filter_fp_rate);
+	std::swap(filter_max_bytes, other.filter_max_bytes);
+	std::swap(filter_stale, other.filter_stale);
+	trees.swap(other.trees);
+	std::swap(tree_count, other.tree_count);
+}
+
+template<	typename V, typename H, typename C>
+void hashtable_sc<V, H, C>::reseed() {
+	guard.reseed();
+	rehash(cap);
+}
+
+template<	typename V, typename H, typename C>
+typename flood_guard<V, H, C>::mode_type hashtable_sc<V, H, C>::hash_mode() const {
+	return guard.get_mode();
+}
+
+template<	typename V, typename H, typename C>
+size_t hashtable_sc<V, H, C>::treeified_buckets() const {
+	return tree_count;
 }
 
 template<	typename V, typename H, typename C>
@@ -129,13 +392,17 @@ void hashtable_sc<V,H,C>::clear(){
 		l.clear();
 	}
 	count = 0;
+	filter.clear();
+	filter_stale = 0;
+	trees.clear();
+	tree_count = 0;
 }
 
 //=========  PRIVATE FUNCITONS  =============
 
 template<typename V, typename H, typename C>
 double hashtable_sc<V, H, C>::load_factor() const {
-	return (double)count / cap;
+	return cap == 0 ? 0 : (double)count / cap;
 }
 
 template<typename V, typename H, typename C>
@@ -153,7 +420,439 @@ bool hashtable_sc<V, H, C>::empty() const {
 	return count == 0;
 }
 
+template<	typename V, typename H, typename C>
+double hashtable_sc<V, H, C>::mean_probe_length() const {
+	if (count == 0) return 0;
+	double visits = 0;
+	for (const std::list<V>& list : data)
+		visits += (double)list.size() * (list.size() + 1) / 2;
+	return visits / count;
+}
+
+
+
+template<typename V, typename H, typename C>
+template<typename P>
+size_t hashtable_sc<V, H, C>::erase_if(P pred, execution_policy policy) {
+	std::vector<size_t> removed(chunk_count(policy), 0);
+	parallel_for(policy, cap, [&](size_t chunk, size_t first, size_t last) {
+		for (size_t i = first; i < last; i++) {
+			std::list<V>& list = data[i];
+			size_t old_size = list.size();
+			list.remove_if([&pred](const V& item) {
+				return pred(item);
+			});
+			removed[chunk] += old_size - list.size();
+		}
+	});
+	size_t erased = 0;
+	for (size_t n : removed)
+		erased += n;
+	count -= erased;
+	filter_erased(erased);
+	rebuild_trees();
+	return erased;
+}
 
+template<typename V, typename H, typename C>
+std::vector<typename hashtable_sc<V, H, C>::partition> hashtable_sc<V, H, C>::partitions(size_t n) const {
+	if (n == 0) n = 1;
+	std::vector<partition> parts;
+	parts.reserve(n);
+	const_iterator first = begin();
+	size_t bucket = 0;
+	size_t seen = 0; //values in the buckets before bucket
+	for (size_t k = 1; k <= n; k++) {
+		//partition k - 1 ends at the first bucket that has count * k / n values before it
+		size_t target = count * k / n;
+		while (bucket < cap && seen < target)
+			seen += data[bucket++].size();
+		const_iterator last = k == n ? end() : iterator_at(bucket);
+		parts.push_back(partition(first, last));
+		first = last;
+	}
+	return parts;
+}
+
+template<typename V, typename H, typename C>
+template<typename F>
+void hashtable_sc<V, H, C>::for_each(execution_policy policy, F fn) const {
+	std::vector<partition> parts = partitions(chunk_count(policy));
+	parallel_for(policy, parts.size(), [&](size_t, size_t first, size_t last) {
+		for (size_t k = first; k < last; k++) {
+			for (const V& item : parts[k])
+				fn(item);
+		}
+	});
+}
+
+//=========  SET ALGEBRA  =============
+
+template<typename V, typename H, typename C>
+void hashtable_sc<V, H, C>::merge(const hashtable_sc& other, execution_policy policy) {
+	if (this == &other) return;
+
+	if (cap == other.cap && guard == other.guard) {
+		//bucket aligned: a value of other.data[i] can only be stored in data[i]
+		std::vector<size_t> added(chunk_count(policy), 0);
+		parallel_for(policy, cap, [&](size_t chunk, size_t first, size_t last) {
+			for (size_t i = first; i < last; i++) {
+				std::list<V>& list = data[i];
+				size_t old_size = list.size();
+				for (const V& item : other.data[i]) {
+					if (!bucket_contains(i, item))
+						list.push_back(item);
+				}
+				added[chunk] += list.size() - old_size;
+			}
+		});
+		for (size_t n : added)
+			count += n;
+		rebuild_trees();
+		reserve(count);
+		if (filter.enabled())
+			rebuild_filter();
+		return;
+	}
+
+	if (other.count > count) {
+		//cheaper to copy the larger table and add the smaller one to it
+		hashtable_sc result(other);
+		result.reserve(count + other.count);
+		for (std::list<V>& list : data) {
+			for (V& item : list)
+				result.insert(std::move(item));
+		}
+		data.swap(result.data);
+		count = result.count;
+		cap = result.cap;
+		guard = result.guard;
+		trees.swap(result.trees);
+		std::swap(tree_count, result.tree_count);
+		if (filter.enabled())
+			rebuild_filter();
+		return;
+	}
+
+	reserve(count + other.count);
+	for (const std::list<V>& list : other.data) {
+		for (const V& item : list)
+			insert(item);
+	}
+}
+
+template<typename V, typename H, typename C>
+void hashtable_sc<V, H, C>::intersect(const hashtable_sc& other, execution_policy policy) {
+	if (this == &other) return;
+
+	bool aligned = cap == other.cap && guard == other.guard;
+	if (!aligned && other.count < count) {
+		//probe the smaller table and move the matching nodes into a new bucket vector
+		bucket_vector kept(cap);
+		size_t kept_count = 0;
+		for (const std::list<V>& list : other.data) {
+			for (const V& item : list) {
+				size_t hash = guard(item);
+				int index = hash % (int)cap;
+				std::list<V>& bucket = data[index];
+				auto it = bucket_find(index, hash, item);
+				if (it != bucket.end()) {
+					kept[index].splice(kept[index].end(), bucket, it);
+					kept_count++;
+				}
+			}
+		}
+		data.swap(kept);
+		filter_erased(count - kept_count);
+		count = kept_count;
+		rebuild_trees();
+		return;
+	}
+
+	std::vector<size_t> removed(chunk_count(policy), 0);
+	parallel_for(policy, cap, [&](size_t chunk, size_t first, size_t last) {
+		for (size_t i = first; i < last; i++) {
+			std::list<V>& list = data[i];
+			size_t old_size = list.size();
+			list.remove_if([&](const V& item) {
+				return aligned ? !other.bucket_contains(i, item) : !other.contains(item);
+			});
+			removed[chunk] += old_size - list.size();
+		}
+	});
+	for (size_t n : removed) {
+		count -= n;
+		filter_erased(n);
+	}
+	rebuild_trees();
+}
+
+template<typename V, typename H, typename C>
+void hashtable_sc<V, H, C>::difference(const hashtable_sc& other, execution_policy policy) {
+	if (this == &other) {
+		clear();
+		return;
+	}
+
+	bool aligned = cap == other.cap && guard == other.guard;
+	if (!aligned && other.count < count) {
+		//probe the smaller table and unlink its values from this one
+		for (const std::list<V>& list : other.data) {
+			for (const V& item : list) {
+				size_t hash = guard(item);
+				int index = hash % (int)cap;
+				auto it = bucket_find(index, hash, item);
+				if (it != data[index].end()) {
+					untrack(index, hash, it);
+					data[index].erase(it);
+					count--;
+					filter_erased(1);
+				}
+			}
+		}
+		return;
+	}
+
+	std::vector<size_t> removed(chunk_count(policy), 0);
+	parallel_for(policy, cap, [&](size_t chunk, size_t first, size_t last) {
+		for (size_t i = first; i < last; i++) {
+			std::list<V>& list = data[i];
+			size_t old_size = list.size();
+			list.remove_if([&](const V& item) {
+				return aligned ? other.bucket_contains(i, item) : other.contains(item);
+			});
+			removed[chunk] += old_size - list.size();
+		}
+	});
+	for (size_t n : removed) {
+		count -= n;
+		filter_erased(n);
+	}
+	rebuild_trees();
+}
+
+template<typename V, typename H, typename C>
+bool hashtable_sc<V, H, C>::is_subset(const hashtable_sc& other, execution_policy policy) const {
+	if (count > other.count) return false;
+
+	bool aligned = cap == other.cap && guard == other.guard;
+	std::atomic<bool> subset(true);
+	parallel_for(policy, cap, [&](size_t, size_t first, size_t last) {
+		for (size_t i = first; i < last && subset.load(std::memory_order_relaxed); i++) {
+			for (const V& item : data[i]) {
+				if (aligned ? !other.bucket_contains(i, item) : !other.contains(item)) {
+					subset = false;
+					break;
+				}
+			}
+		}
+	});
+	return subset;
+}
+
+template<typename V, typename H, typename C>
+bool hashtable_sc<V, H, C>::equals(const hashtable_sc& other, execution_policy policy) const {
+	return count == other.count && is_subset(other, policy);
+}
+
+template<typename V, typename H, typename C>
+bool hashtable_sc<V, H, C>::list_contains(const std::list<V>& list, const V& value) {
+	for (const V& item : list) {
+		if (C()(item, value)) return true;
+	}
+	return false;
+}
+
+template<typename V, typename H, typename C>
+void hashtable_sc<V, H, C>::reserve(size_t n) {
+	size_t new_cap = std::max<size_t>(cap, 1);
+	while ((double)n / new_cap > 0.75)
+		new_cap *= 2;
+	if (new_cap != cap)
+		rehash(new_cap);
+}
+
+//=========  NODE HANDLES  =============
+
+template<typename V, typename H, typename C>
+typename hashtable_sc<V, H, C>::node_handle hashtable_sc<V, H, C>::extract(const V& value) {
+	node_handle node;
+	if (cap == 0) return node; //moved from
+	size_t hash = guard(value);
+	int index = hash % (int)cap;
+	std::list<V>& list = data[index];
+	auto it = bucket_find(index, hash, value);
+	if (it != list.end()) {
+		untrack(index, hash, it);
+		node.node.splice(node.node.end(), list, it);
+		count--;
+		filter_erased(1);
+	}
+	return node;
+}
+
+template<typename V, typename H, typename C>
+bool hashtable_sc<V, H, C>::insert(node_handle&& node) {
+	if (node.empty()) return false;
+
+	if (cap == 0) rehash(1); //moved from
+	size_t hash = guard(node.value());
+	int index = hash % (int)cap;
+	if (bucket_contains(index, hash, node.value())) return false;
+
+	data[index].splice(data[index].end(), node.node);
+	inserted(index, hash);
+	return true;
+}
+
+template<typename V, typename H, typename C>
+void hashtable_sc<V, H, C>::merge(hashtable_sc&& other) {
+	if (this == &other) return;
+
+	//grow once up front, the nodes are spliced without further load checks
+	reserve(count + other.count);
+	bool aligned = cap == other.cap && guard == other.guard;
+	size_t moved = 0;
+	for (size_t i = 0; i < other.cap; i++) {
+		std::list<V>& list = other.data[i];
+		for (auto it = list.begin(); it != list.end();) {
+			auto next = std::next(it);
+			size_t hash = aligned && !filter.enabled() ? 0 : guard(*it);
+			size_t index = aligned ? i : hash % cap;
+			std::list<V>& bucket = data[index];
+			if (!bucket_contains(index, *it)) {
+				bucket.splice(bucket.end(), list, it);
+				if (filter.enabled())
+					filter.add(hash);
+				moved++;
+			}
+			it = next;
+		}
+	}
+	count += moved;
+	other.count -= moved;
+	other.filter_erased(moved);
+	rebuild_trees();
+	other.rebuild_trees();
+}
+
+//=========  CHAIN TREES  =============
+
+//the chain searched with its tree if it has one, end() if value is not stored
+template<typename V, typename H, typename C>
+typename std::list<V>::const_iterator hashtable_sc<V, H, C>::bucket_find(size_t index, size_t hash, const V& value) const {
+	const std::list<V>& list = data[index];
+	if (!trees.empty() && trees[index]) {
+		//values with equal hashes are only ordered if V has operator<, the range is searched with C
+		auto range = trees[index]->equal_range(tree_entry{ hash, &value, typename std::list<V>::iterator() });
+		for (auto it = range.first; it != range.second; ++it) {
+			if (C()(*it->value, value)) return it->node;
+		}
+		return list.end();
+	}
+	return std::find_if(list.begin(), list.end(), [&value](const V& element) {
+		return C()(element, value);
+	});
+}
+
+template<typename V, typename H, typename C>
+bool hashtable_sc<V, H, C>::bucket_contains(size_t index, size_t hash, const V& value) const {
+	return bucket_find(index, hash, value) != data[index].end();
+}
+
+//for callers without the hash, it is only computed for a treeified bucket. The merges add values
+//to a chain without updating its tree: the values still to come differ from the added ones, so
+//searching the values from before the merge is enough, the trees are rebuilt afterwards
+template<typename V, typename H, typename C>
+bool hashtable_sc<V, H, C>::bucket_contains(size_t index, const V& value) const {
+	if (!trees.empty() && trees[index])
+		return bucket_contains(index, guard(value), value);
+	return list_contains(data[index], value);
+}
+
+template<typename V, typename H, typename C>
+void hashtable_sc<V, H, C>::treeify(size_t index) {
+	if (trees.empty())
+		trees.resize(cap);
+	std::unique_ptr<chain_tree> tree(new chain_tree());
+	std::list<V>& list = data[index];
+	for (auto it = list.begin(); it != list.end(); ++it)
+		tree->insert(tree_entry{ guard(*it), &*it, it });
+	trees[index] = std::move(tree);
+	tree_count++;
+}
+
+//the vector of trees is released with the last tree, short chains only check that it is empty
+template<typename V, typename H, typename C>
+void hashtable_sc<V, H, C>::untreeify(size_t index) {
+	trees[index].reset();
+	if (--tree_count == 0)
+		trees.clear();
+}
+
+//after a rehash or a change of many chains, one pass over the buckets
+template<typename V, typename H, typename C>
+void hashtable_sc<V, H, C>::rebuild_trees() {
+	trees.clear();
+	tree_count = 0;
+	for (size_t i = 0; i < cap; i++) {
+		if (data[i].size() > TREEIFY_THRESHOLD)
+			treeify(i);
+	}
+}
+
+//called before node is unlinked from its chain, drops the tree if the chain becomes too short
+template<typename V, typename H, typename C>
+void hashtable_sc<V, H, C>::untrack(size_t index, size_t hash, typename std::list<V>::const_iterator node) {
+	if (trees.empty() || !trees[index]) return;
+	if (data[index].size() <= UNTREEIFY_THRESHOLD) {
+		untreeify(index);
+		return;
+	}
+	chain_tree& tree = *trees[index];
+	auto range = tree.equal_range(tree_entry{ hash, &*node, typename std::list<V>::iterator() });
+	for (auto it = range.first; it != range.second; ++it) {
+		if (it->node == node) {
+			tree.erase(it);
+			return;
+		}
+	}
+}
+
+//=========  BLOOM FILTER  =============
+
+template<typename V, typename H, typename C>
+void hashtable_sc<V, H, C>::enable_bloom_filter(double fp_rate, size_t max_bytes) {
+	filter_fp_rate = fp_rate;
+	filter_max_bytes = max_bytes;
+	rebuild_filter();
+}
+
+template<typename V, typename H, typename C>
+void hashtable_sc<V, H, C>::disable_bloom_filter() {
+	filter = blocked_bloom_filter();
+	filter_stale = 0;
+}
+
+template<typename V, typename H, typename C>
+void hashtable_sc<V, H, C>::rebuild_filter() {
+	//dimensioned for the largest size before the next rehash
+	filter = blocked_bloom_filter(std::max(cap * 3 / 4, count), filter_fp_rate, filter_max_bytes);
+	for (const std::list<V>& list : data) {
+		for (const V& item : list)
+			filter.add(guard(item));
+	}
+	filter_stale = 0;
+}
+
+template<typename V, typename H, typename C>
+void hashtable_sc<V, H, C>::filter_erased(size_t n) {
+	if (!filter.enabled()) return;
+	//stale bits raise the false positive rate, rebuild once they reach a quarter of the dimensioned size
+	filter_stale += n;
+	if (filter_stale * 4 > std::max(cap * 3 / 4, count))
+		rebuild_filter();
+}
 
 //==========  DEFINITION OF ITERATOR CLASS ==============
 
@@ -162,18 +861,20 @@ template<typename V, typename H, typename C>
 class hashtable_sc<V, H, C>::const_iterator : public iterator_base {
 
 	private:		
-		typename std::vector<std::list<V>>::const_iterator data_iterator; // Iterator of data vector for accessing lists
+		typename bucket_vector::const_iterator data_iterator; // Iterator of data vector for accessing lists
 		typename std::list<V>::const_iterator list_iterator; // iterator of list for accessing values
-		typename const typename std::vector<std::list<V>>* data_ptr; //pointer to data vector for comparisons
+		const bucket_vector* data_ptr; //pointer to data vector for comparisons
 
 	public:
 		
-		const_iterator(	const typename std::vector<std::list<V>>* data,
-										const typename std::vector<std::list<V>>::const_iterator data_it)
-										: data_iterator(data_it), data_ptr(data){												
+		const_iterator(	const bucket_vector* data,
+										const typename bucket_vector::const_iterator data_it)
+										: data_iterator(data_it), list_iterator(), data_ptr(data){												
+												if(data_ptr->empty())
+													return; //no buckets -> begin() == end()
 												if(data_iterator == data_ptr->begin()){												
 													//begin() called -> find first non-empty list or end
-													while(data_iterator->empty() && data_iterator != data_ptr->end()){
+													while(data_iterator != data_ptr->end() && data_iterator->empty()){
 														data_iterator++;
 													}													
 													if(data_iterator == data_ptr->end()){
@@ -182,8 +883,9 @@ class hashtable_sc<V, H, C>::const_iterator : public iterator_base {
 														data_iterator--;
 														list_iterator = data_iterator->end();
 														data_iterator++;
+													} else {
+														list_iterator = data_iterator->begin();
 													}
-													list_iterator = data_iterator->begin();													
 												}else {
 													// end() called -> set list_iterator to end of end of last list
 													data_iterator--;
@@ -193,7 +895,13 @@ class hashtable_sc<V, H, C>::const_iterator : public iterator_base {
 
 											}
 
-		typename std::vector<std::list<V>>::const_iterator get_data_iterator() const {
+		//iterator at a value, used for partition boundaries
+		const_iterator(	const bucket_vector* data,
+										const typename bucket_vector::const_iterator data_it,
+										const typename std::list<V>::const_iterator list_it)
+										: data_iterator(data_it), list_iterator(list_it), data_ptr(data) {}
+
+		typename bucket_vector::const_iterator get_data_iterator() const {
 			return data_iterator;
 		}
 
@@ -244,20 +952,6 @@ class hashtable_sc<V, H, C>::const_iterator : public iterator_base {
 
 		const_iterator& operator++(){					
 			if (data_iterator != data_ptr->end()) {
-				if (!hasNext()) {
-					//end reached -> set to end state
-					data_iterator = data_ptr->end();
-
-					//set list iterator to end of last list
-					data_iterator--;
-					list_iterator = data_iterator->end();
-
-					//go back to data_ptr->end
-					data_iterator++;
-
-					return *this;
-				}
-				//at this point there is definitely a next value
 				list_iterator++;
 
 				if (list_iterator == data_iterator->end()) {
@@ -265,8 +959,13 @@ class hashtable_sc<V, H, C>::const_iterator : public iterator_base {
 					do {
 						++data_iterator;
 					} while (data_iterator != data_ptr->end() && data_iterator->empty());
-					// Found a non-empty list, reset value_iterator
-					list_iterator = data_iterator->begin();
+
+					if (data_iterator == data_ptr->end()) {
+						//end reached -> set list iterator to end of last list like end()
+						list_iterator = std::prev(data_iterator)->end();
+					} else {
+						list_iterator = data_iterator->begin();
+					}
 				}
 			}
 			return *this;
@@ -297,33 +996,7 @@ class hashtable_sc<V, H, C>::const_iterator : public iterator_base {
 
 		const_iterator operator++(int) {		
 			const_iterator temp = *this; // Preserve state because of post-increment
-
-			if (data_iterator != data_ptr->end()) {
-				if(!hasNext()){
-					//end reached -> set to end state
-					data_iterator = data_ptr->end();
-
-					//set list iterator to end of last list
-					data_iterator--;
-					list_iterator = data_iterator->end();
-
-					//go back to data.end
-					data_iterator++;
-
-					return temp;
-				}
-				//at this point there is definitely a next value
-				list_iterator++;
-
-				if (list_iterator == data_iterator->end()) {
-					// end of list reached -> find next non-empty one
-					do {
-						++data_iterator;
-					} while (data_iterator != data_ptr->end() && data_iterator->empty());
-					// Found a non-empty list, reset value_iterator
-					list_iterator = data_iterator->begin();				
-				}
-			}			
+			++(*this);
 			return temp;
 		}
 
@@ -355,20 +1028,65 @@ class hashtable_sc<V, H, C>::const_iterator : public iterator_base {
 };
 
 template<typename V, typename H, typename C>
-bool operator==(const hashtable_sc<V,H,C> lhs, const hashtable_sc<V, H, C> rhs){
-	if(lhs.size() != rhs.size()) return false;
+bool operator==(const hashtable_sc<V,H,C>& lhs, const hashtable_sc<V, H, C>& rhs){
+	return lhs.equals(rhs);
+}
 
-	auto iter_lhs = lhs.begin();
-	auto iter_rhs = rhs.begin();
+//==========  DEFINITION OF PARTITION CLASS ==============
 
-	while(iter_lhs != lhs.end()){
-		if(!(C()(*iter_lhs, *iter_rhs))) return false;
-		iter_lhs++;
-		iter_rhs++;
-	}
 
-	return true;
-}
+template<typename V, typename H, typename C>
+class hashtable_sc<V, H, C>::partition {
+
+	private:
+		const_iterator first;
+		const_iterator last;
+
+	public:
+
+		partition(const_iterator first, const_iterator last) : first(first), last(last) {}
+
+		const_iterator begin() const {
+			return first;
+		}
+
+		const_iterator end() const {
+			return last;
+		}
+
+		bool empty() const {
+			return first == last;
+		}
+};
+
+//==========  DEFINITION OF NODE HANDLE CLASS ==============
 
 
+template<typename V, typename H, typename C>
+class hashtable_sc<V, H, C>::node_handle {
+
+	private:
+		friend class hashtable_sc;
+		std::list<V> node; //empty or exactly one node
+
+	public:
+
+		node_handle() {}
+
+		bool empty() const {
+			return node.empty();
+		}
+
+		explicit operator bool() const {
+			return !node.empty();
+		}
 
+		//the value may be changed while it is not stored in a table
+		V& value() {
+			return node.front();
+		}
+
+		const V& value() const {
+			return node.front();
+		}
+};
@@ -0,0 +1,275 @@
+#pragma once
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <ostream>
+#include "hash.h"
+#include "hashtable.h"
+#include "hashtable_oa.h"
+
+
+
+//set for very few values. Up to N values are stored inside the object and searched
+//linearly without hashing, so small sets need no heap allocation at all.
+//The first insert beyond N moves the values into a hashtable_oa, clear() returns to inline mode
+template<	typename V,
+					typename H = default_hash<V>,
+					typename C = std::equal_to<V>,
+					size_t N = 8>
+class hashtable_small : hashtable<V, H, C> {
+
+	public:
+		typedef hashtable_oa<V, H, C> large_table;
+
+		hashtable_small() {
+			inline_count = 0;
+		}
+
+		hashtable_small(const hashtable_small& other) {
+			*this = other;
+		}
+
+		hashtable_small& operator=(const hashtable_small& other) {
+			if (this != &other) {
+				std::copy(other.values, other.values + other.inline_count, values);
+				inline_count = other.inline_count;
+				table.reset(other.table ? new large_table(*other.table) : nullptr);
+			}
+			return *this;
+		}
+
+		~hashtable_small() {}
+		void insert(const V& value)override;
+		void erase(const V& value)override;
+		bool contains(const V& value) const override;
+		void rehash(size_t new_n_buckets)override;
+		void clear()override;
+
+		double load_factor() const override;
+		size_t size() const override;
+		size_t capacity() const override;
+		bool empty() const override;
+
+		bool is_inline() const;
+
+		friend std::ostream& operator<<(std::ostream& os, const hashtable_small<V, H, C, N>& ht) {
+			if (ht.table)
+				return os << *ht.table;
+			for (size_t i = 0; i < ht.inline_count; i++)
+				os << ht.values[i] << " ";
+			os << "\n";
+			return os;
+		}
+
+		class const_iterator;
+
+		const_iterator begin() const {
+			if (table)
+				return const_iterator(table->begin());
+			return const_iterator(values);
+		}
+
+		const_iterator end() const {
+			if (table)
+				return const_iterator(table->end());
+			return const_iterator(values + inline_count);
+		}
+
+		using iterator_category = std::bidirectional_iterator_tag;
+		using value_type = V const;
+		using difference_type = std::ptrdiff_t;
+		using const_pointer = V const*;
+		using const_reference = V const&;
+
+		typedef std::iterator<std::bidirectional_iterator_tag, value_type, difference_type, const_pointer,
+			const_reference> iterator_base;
+
+	private:
+		V values[N];
+		size_t inline_count;
+		std::unique_ptr<large_table> table; //null while the values are stored inline
+
+		void switch_to_table(size_t capacity);
+};
+
+//=========  PUBLIC FUNCITONS  =============
+
+template<	typename V, typename H, typename C, size_t N>
+void hashtable_small<V, H, C, N>::insert(const V& value) {
+	if (table) {
+		table->insert(value);
+		return;
+	}
+	if (contains(value)) return;
+
+	if (inline_count == N) {
+		//capacity for twice the inline values at the table's maximum load factor
+		switch_to_table(N * 4);
+		table->insert(value);
+		return;
+	}
+	values[inline_count++] = value;
+}
+
+template<	typename V, typename H, typename C, size_t N>
+void hashtable_small<V, H, C, N>::erase(const V& value) {
+	if (table) {
+		table->erase(value);
+		return;
+	}
+	for (size_t i = 0; i < inline_count; i++) {
+		if (C()(values[i], value)) {
+			//order does not matter -> fill the gap with the last value
+			values[i] = values[--inline_count];
+			return;
+		}
+	}
+}
+
+template<	typename V, typename H, typename C, size_t N>
+bool hashtable_small<V, H, C, N>::contains(const V& value) const {
+	if (table)
+		return table->contains(value);
+	for (size_t i = 0; i < inline_count; i++) {
+		if (C()(values[i], value)) return true;
+	}
+	return false;
+}
+
+template<	typename V, typename H, typename C, size_t N>
+void hashtable_small<V, H, C, N>::rehash(size_t new_n_buckets) {
+	if (table)
+		table->rehash(new_n_buckets);
+	else if (new_n_buckets > N)
+		switch_to_table(new_n_buckets);
+}
+
+template<	typename V, typename H, typename C, size_t N>
+void hashtable_small<V, H, C, N>::clear() {
+	table.reset();
+	inline_count = 0;
+}
+
+template<typename V, typename H, typename C, size_t N>
+double hashtable_small<V, H, C, N>::load_factor() const {
+	return (double)size() / capacity();
+}
+
+template<typename V, typename H, typename C, size_t N>
+size_t hashtable_small<V, H, C, N>::size() const {
+	return table ? table->size() : inline_count;
+}
+
+template<typename V, typename H, typename C, size_t N>
+size_t hashtable_small<V, H, C, N>::capacity() const {
+	return table ? table->capacity() : N;
+}
+
+template<typename V, typename H, typename C, size_t N>
+bool hashtable_small<V, H, C, N>::empty() const {
+	return size() == 0;
+}
+
+template<typename V, typename H, typename C, size_t N>
+bool hashtable_small<V, H, C, N>::is_inline() const {
+	return !table;
+}
+
+//=========  PRIVATE FUNCITONS  =============
+
+template<typename V, typename H, typename C, size_t N>
+void hashtable_small<V, H, C, N>::switch_to_table(size_t capacity) {
+	table.reset(new large_table(capacity));
+	for (size_t i = 0; i < inline_count; i++)
+		table->insert(values[i]);
+	inline_count = 0;
+}
+
+//==========  DEFINITION OF ITERATOR CLASS ==============
+
+
+template<typename V, typename H, typename C, size_t N>
+class hashtable_small<V, H, C, N>::const_iterator : public iterator_base {
+
+	private:
+		typedef typename large_table::const_iterator large_iterator;
+
+		const V* value_ptr; //position in the inline values, null in table mode
+		large_iterator table_iterator; //position in the table, unused in inline mode
+
+		//iterator of an empty table, gives table_iterator a valid state in inline mode
+		static const large_iterator& unused_iterator() {
+			static const large_table empty_table(1);
+			static const large_iterator it = empty_table.end();
+			return it;
+		}
+
+	public:
+
+		const_iterator(const V* value_ptr) : value_ptr(value_ptr), table_iterator(unused_iterator()) {}
+
+		const_iterator(large_iterator table_iterator) : value_ptr(nullptr), table_iterator(table_iterator) {}
+
+		const V* get_value_ptr() const {
+			return value_ptr;
+		}
+
+		large_iterator get_table_iterator() const {
+			return table_iterator;
+		}
+
+		bool operator==(const_iterator const& rhs) const {
+			return value_ptr == rhs.get_value_ptr() && table_iterator == rhs.get_table_iterator();
+		}
+
+		bool operator!=(const_iterator const& rhs) const {
+			return !(*this == rhs);
+		}
+
+		const_reference operator*() const {
+			return value_ptr ? *value_ptr : *table_iterator;
+		}
+
+		const_pointer operator->() const {
+			return &(**this);
+		}
+
+		const_iterator& operator++() {
+			if (value_ptr)
+				value_ptr++;
+			else
+				++table_iterator;
+			return *this;
+		}
+
+		const_iterator& operator--() {
+			if (value_ptr)
+				value_ptr--;
+			else
+				--table_iterator;
+			return *this;
+		}
+
+		const_iterator operator++(int) {
+			const_iterator temp = *this; // Preserve state because of post-increment
+			++(*this);
+			return temp;
+		}
+
+		const_iterator operator--(int) {
+			const_iterator temp = *this; //preserve state because post increment
+			--(*this);
+			return temp;
+		}
+};
+
+template<typename V, typename H, typename C, size_t N>
+bool operator==(const hashtable_small<V, H, C, N>& lhs, const hashtable_small<V, H, C, N>& rhs) {
+	if (lhs.size() != rhs.size()) return false;
+
+	for (const V& item : lhs) {
+		if (!rhs.contains(item)) return false;
+	}
+	return true;
+}
@@ -0,0 +1,347 @@
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <ostream>
+#include <string_view>
+#include <vector>
+#include "aligned_allocator.h"
+#include "hash.h"
+
+
+
+//open addressing set of strings. The characters of all strings are appended to one arena,
+//the slots only keep offset, length and a hash tag, so a short string costs 16 bytes of slot
+//plus its characters and no separate allocation.
+//All operations take a std::string_view, std::string and const char* convert to it,
+//so lookups never construct a std::string.
+//A slot keeps the length in 32 bits, strings longer than MAX_LENGTH are not stored
+template<typename H = default_hash<std::string_view>>
+class hashtable_string {
+
+	public:
+
+		static const size_t MAX_LENGTH = UINT32_MAX;
+
+		hashtable_string(size_t capacity) {
+			cap = slot_count_for(capacity);
+			data = slot_vector(cap);
+			count = 0;
+			deleted = 0;
+			garbage = 0;
+		}
+
+		~hashtable_string() {}
+		void insert(std::string_view value);
+		void erase(std::string_view value);
+		bool contains(std::string_view value) const;
+		void rehash(size_t new_n_buckets);
+		void clear();
+
+		double load_factor() const;
+		size_t size() const;
+		size_t capacity() const;
+		bool empty() const;
+
+		size_t arena_size() const;
+
+		friend std::ostream& operator<<(std::ostream& os, const hashtable_string<H>& ht) {
+			for (std::string_view item : ht)
+				os << item << " ";
+			os << "\n";
+			return os;
+		}
+
+		class const_iterator;
+
+		const_iterator begin() const {
+			return const_iterator(this, 0);
+		}
+
+		const_iterator end() const {
+			return const_iterator(this, cap);
+		}
+
+		using iterator_category = std::bidirectional_iterator_tag;
+		using value_type = std::string_view;
+		using difference_type = std::ptrdiff_t;
+		using const_pointer = std::string_view const*;
+		using const_reference = std::string_view;
+
+		typedef std::iterator<std::bidirectional_iterator_tag, value_type, difference_type, const_pointer,
+			const_reference> iterator_base;
+
+		//tag = 0 -> empty
+		//tag = 1 -> deleted
+		//tag > 1 -> occupied, the tag holds the upper hash bits
+		struct Slot {
+			uint64_t offset; //position of the first character in the arena
+			uint32_t length;
+			uint32_t tag;
+		};
+
+	private:
+		typedef std::vector<Slot, huge_page_allocator<Slot>> slot_vector;
+
+		slot_vector data;
+		std::vector<char> arena; //append only, compacted on rehash
+		size_t count;
+		size_t deleted; //slots with tag 1
+		size_t garbage; //arena bytes of erased strings
+		size_t cap; //always a power of two
+
+		static size_t slot_count_for(size_t capacity);
+		static uint32_t get_tag(uint64_t hash);
+		uint64_t get_hash(std::string_view value) const;
+		std::string_view view(const Slot& slot) const;
+		size_t indexOf(std::string_view value, uint64_t hash) const;
+		void place(const Slot& slot, uint64_t hash);
+};
+
+//=========  PUBLIC FUNCITONS  =============
+
+template<typename H>
+void hashtable_string<H>::insert(std::string_view value) {
+	assert(value.size() <= MAX_LENGTH);
+	if (value.size() > MAX_LENGTH) return; //the slot could not hold its length
+	uint64_t hash = get_hash(value);
+	if (indexOf(value, hash) != (size_t)-1) return;
+
+	//the characters are copied once, into the arena
+	Slot slot = { arena.size(), (uint32_t)value.size(), get_tag(hash) };
+	arena.insert(arena.end(), value.begin(), value.end());
+	place(slot, hash);
+	count++;
+
+	//deleted slots lengthen probe sequences like occupied ones
+	if ((double)(count + deleted) / cap > 0.75)
+		rehash(count * 2 > cap ? cap * 2 : cap);
+}
+
+template<typename H>
+void hashtable_string<H>::erase(std::string_view value) {
+	size_t index = indexOf(value, get_hash(value));
+	if (index != (size_t)-1) {
+		garbage += data[index].length;
+		data[index].tag = 1;
+		count--;
+		deleted++;
+
+		//compact once erased strings fill half the arena. Waiting for at least cap bytes
+		//keeps the cost of the rehash proportional to the erased data
+		if (garbage > arena.size() / 2 && garbage >= cap)
+			rehash(cap);
+	}
+}
+
+template<typename H>
+bool hashtable_string<H>::contains(std::string_view value) const {
+	return indexOf(value, get_hash(value)) != (size_t)-1;
+}
+
+template<typename H>
+void hashtable_string<H>::rehash(size_t new_n_buckets) {
+	slot_vector old_data;
+	old_data.swap(data);
+	std::vector<char> old_arena;
+	if (garbage > arena.size() / 2) {
+		//more than half of the arena belongs to erased strings -> compact it
+		old_arena.swap(arena);
+		arena.reserve(old_arena.size() - garbage);
+	}
+
+	cap = slot_count_for(std::max(new_n_buckets, count));
+	data = slot_vector(cap);
+	deleted = 0;
+
+	for (const Slot& slot : old_data) {
+		if (slot.tag < 2) continue;
+		Slot moved = slot;
+		if (!old_arena.empty()) {
+			moved.offset = arena.size();
+			arena.insert(arena.end(), old_arena.begin() + slot.offset, old_arena.begin() + slot.offset + slot.length);
+		}
+		place(moved, get_hash(view(moved)));
+	}
+	if (!old_arena.empty())
+		garbage = 0;
+}
+
+template<typename H>
+void hashtable_string<H>::clear() {
+	std::fill(data.begin(), data.end(), Slot{ 0, 0, 0 });
+	arena.clear();
+	count = 0;
+	deleted = 0;
+	garbage = 0;
+}
+
+template<typename H>
+double hashtable_string<H>::load_factor() const {
+	return (double)count / cap;
+}
+
+template<typename H>
+size_t hashtable_string<H>::size() const {
+	return count;
+}
+
+template<typename H>
+size_t hashtable_string<H>::capacity() const {
+	return cap;
+}
+
+template<typename H>
+bool hashtable_string<H>::empty() const {
+	return count == 0;
+}
+
+template<typename H>
+size_t hashtable_string<H>::arena_size() const {
+	return arena.size();
+}
+
+//=========  PRIVATE FUNCITONS  =============
+
+template<typename H>
+size_t hashtable_string<H>::slot_count_for(size_t capacity) {
+	size_t n = 8;
+	while (n < capacity)
+		n *= 2;
+	return n;
+}
+
+template<typename H>
+uint32_t hashtable_string<H>::get_tag(uint64_t hash) {
+	uint32_t tag = (uint32_t)(hash >> 32);
+	return tag < 2 ? 2 : tag;
+}
+
+template<typename H>
+uint64_t hashtable_string<H>::get_hash(std::string_view value) const {
+	return mixed_hash<H>(value);
+}
+
+template<typename H>
+std::string_view hashtable_string<H>::view(const Slot& slot) const {
+	return std::string_view(arena.data() + slot.offset, slot.length);
+}
+
+template<typename H>
+size_t hashtable_string<H>::indexOf(std::string_view value, uint64_t hash) const {
+	uint32_t tag = get_tag(hash);
+	size_t index = (size_t)hash & (cap - 1);
+	while (data[index].tag != 0) {
+		const Slot& slot = data[index];
+		//tag and length reject nearly all other strings before the arena is read
+		//an empty arena or view may have no data pointer, memcmp needs a valid one even for 0 bytes
+		if (slot.tag == tag && slot.length == value.size() &&
+			(value.size() == 0 || std::memcmp(arena.data() + slot.offset, value.data(), value.size()) == 0))
+			return index;
+		index = (index + 1) & (cap - 1);
+	}
+	return -1;
+}
+
+template<typename H>
+void hashtable_string<H>::place(const Slot& slot, uint64_t hash) {
+	size_t index = (size_t)hash & (cap - 1);
+	while (data[index].tag > 1)
+		index = (index + 1) & (cap - 1);
+	if (data[index].tag == 1)
+		deleted--;
+	data[index] = slot;
+}
+
+//==========  DEFINITION OF ITERATOR CLASS ==============
+
+
+template<typename H>
+class hashtable_string<H>::const_iterator : public iterator_base {
+
+	private:
+		const hashtable_string* table; //table for accessing slots and arena
+		size_t position; //slot index
+
+		bool occupied(size_t pos) const {
+			return table->data[pos].tag > 1;
+		}
+
+	public:
+
+		const_iterator(const hashtable_string* table, size_t position)
+										: table(table), position(position) {
+			if (position == 0) {//begin() called -> find first element
+				while (this->position != table->cap && !occupied(this->position))
+					this->position++;
+			}
+			//no action needed for end()
+		}
+
+		size_t get_position() const {
+			return position;
+		}
+
+		bool hasNext() {
+			size_t next = position;
+			while (next != table->cap && !occupied(next))
+				next++;
+			return next != table->cap;
+		}
+
+		bool operator==(const_iterator const& rhs) const {
+			return position == rhs.get_position();
+		}
+
+		bool operator!=(const_iterator const& rhs) const {
+			return position != rhs.get_position();
+		}
+
+		//the view points into the arena and stays valid until the next insert or rehash
+		std::string_view operator*() const {
+			return table->view(table->data[position]);
+		}
+
+		const_iterator& operator++() {
+			if (position != table->cap) {
+				do {
+					position++;
+				} while (position != table->cap && !occupied(position));
+			}
+			return *this;
+		}
+
+		const_iterator& operator--() {
+			if (position != 0) {
+				do {
+					position--;
+				} while (position != 0 && !occupied(position));
+			}
+			return *this;
+		}
+
+		const_iterator operator++(int) {
+			const_iterator temp = *this; // Preserve state because of post-increment
+			++(*this);
+			return temp;
+		}
+
+		const_iterator operator--(int) {
+			const_iterator temp = *this; //preserve state because post increment
+			--(*this);
+			return temp;
+		}
+};
+
+template<typename H>
+bool operator==(const hashtable_string<H>& lhs, const hashtable_string<H>& rhs) {
+	if (lhs.size() != rhs.size()) return false;
+
+	for (std::string_view item : lhs) {
+		if (!rhs.contains(item)) return false;
+	}
+	return true;
+}
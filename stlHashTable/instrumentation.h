@@ -0,0 +1,227 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define INSTRUMENTATION_TSC
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define INSTRUMENTATION_TSC
+#endif
+
+//opt-in latency instrumentation of hashtable_sc and hashtable_oa.
+//With HASHTABLE_INSTRUMENTATION defined before the tables are included, every table has stats():
+//lock-free histograms of the insert, erase and contains latencies and callbacks around each rehash.
+//Without it the TABLE_* macros below expand to nothing and the tables carry no extra member,
+//so uninstrumented builds pay nothing
+
+//timestamp in ticks: the time stamp counter on x86, steady_clock nanoseconds elsewhere
+inline uint64_t tsc_now() {
+#ifdef INSTRUMENTATION_TSC
+	return __rdtsc();
+#else
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+//nanoseconds per tick, measured once against steady_clock over 10 ms
+inline double tsc_ns_per_tick() {
+#ifdef INSTRUMENTATION_TSC
+	static const double ns_per_tick = []() {
+		auto start = std::chrono::steady_clock::now();
+		uint64_t ticks = tsc_now();
+		while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(10)) {}
+		double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+		return ns / (double)(tsc_now() - ticks);
+	}();
+	return ns_per_tick;
+#else
+	return 1.0;
+#endif
+}
+
+//position of the highest set bit, value must not be 0
+inline unsigned highest_bit(uint64_t value) {
+#if defined(_MSC_VER) && defined(_M_X64)
+	unsigned long index;
+	_BitScanReverse64(&index, value);
+	return (unsigned)index;
+#elif defined(__GNUC__)
+	return 63 - (unsigned)__builtin_clzll(value);
+#else
+	unsigned index = 0;
+	while (value >>= 1)
+		index++;
+	return index;
+#endif
+}
+
+//histogram of tick counts in the HDR layout: values below 32 have one bucket each, every
+//following power of two is split into 16 buckets, so any value is known within 1/16 (6%)
+//from 976 counters. record() is one relaxed atomic increment and may run on many threads
+class latency_histogram {
+
+	public:
+		static const unsigned SUB_BITS = 5;
+		static const size_t LINEAR = (size_t)1 << SUB_BITS; //values with their own bucket
+		static const size_t HALF = LINEAR / 2; //buckets per following power of two
+		static const size_t BUCKETS = LINEAR + (64 - SUB_BITS) * HALF;
+
+		latency_histogram() {
+			reset();
+		}
+
+		latency_histogram(const latency_histogram& other) {
+			*this = other;
+		}
+
+		latency_histogram& operator=(const latency_histogram& other) {
+			for (size_t i = 0; i < BUCKETS; i++)
+				counts[i].store(other.counts[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+			total.store(other.total.load(std::memory_order_relaxed), std::memory_order_relaxed);
+			highest.store(other.highest.load(std::memory_order_relaxed), std::memory_order_relaxed);
+			return *this;
+		}
+
+		void record(uint64_t ticks) {
+			counts[bucket_of(ticks)].fetch_add(1, std::memory_order_relaxed);
+			total.fetch_add(1, std::memory_order_relaxed);
+			uint64_t high = highest.load(std::memory_order_relaxed);
+			while (ticks > high && !highest.compare_exchange_weak(high, ticks, std::memory_order_relaxed)) {}
+		}
+
+		//adds the values of other, e.g. to combine the histograms of several threads
+		void merge(const latency_histogram& other) {
+			for (size_t i = 0; i < BUCKETS; i++)
+				counts[i].fetch_add(other.counts[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+			total.fetch_add(other.total.load(std::memory_order_relaxed), std::memory_order_relaxed);
+			uint64_t ticks = other.highest.load(std::memory_order_relaxed);
+			uint64_t high = highest.load(std::memory_order_relaxed);
+			while (ticks > high && !highest.compare_exchange_weak(high, ticks, std::memory_order_relaxed)) {}
+		}
+
+		void reset() {
+			for (std::atomic<uint64_t>& c : counts)
+				c.store(0, std::memory_order_relaxed);
+			total.store(0, std::memory_order_relaxed);
+			highest.store(0, std::memory_order_relaxed);
+		}
+
+		uint64_t count() const {
+			return total.load(std::memory_order_relaxed);
+		}
+
+		//smallest recorded value v in nanoseconds with at least p * count() values <= v,
+		//p in [0, 1]. Values are reported as the middle of their bucket
+		double percentile_ns(double p) const {
+			uint64_t n = count();
+			if (n == 0) return 0;
+			uint64_t rank = (uint64_t)(p * (double)n);
+			if (rank == 0) rank = 1;
+			if (rank > n) rank = n;
+			uint64_t seen = 0;
+			for (size_t i = 0; i < BUCKETS; i++) {
+				seen += counts[i].load(std::memory_order_relaxed);
+				if (seen >= rank)
+					return (double)middle_of(i) * tsc_ns_per_tick();
+			}
+			return max_ns();
+		}
+
+		double max_ns() const {
+			return (double)highest.load(std::memory_order_relaxed) * tsc_ns_per_tick();
+		}
+
+		static size_t bucket_of(uint64_t ticks) {
+			if (ticks < LINEAR)
+				return (size_t)ticks;
+			unsigned shift = highest_bit(ticks) - SUB_BITS + 1;
+			return LINEAR + (shift - 1) * HALF + (size_t)((ticks >> shift) - HALF);
+		}
+
+		//middle of the tick range of a bucket
+		static uint64_t middle_of(size_t bucket) {
+			if (bucket < LINEAR)
+				return bucket;
+			unsigned shift = (unsigned)((bucket - LINEAR) / HALF) + 1;
+			uint64_t first = (uint64_t)((bucket - LINEAR) % HALF + HALF) << shift;
+			return first + ((uint64_t)1 << shift) / 2;
+		}
+
+	private:
+		std::atomic<uint64_t> counts[BUCKETS];
+		std::atomic<uint64_t> total;
+		std::atomic<uint64_t> highest;
+};
+
+//records the ticks from construction to destruction
+class latency_timer {
+
+	public:
+		explicit latency_timer(latency_histogram& histogram) : histogram(histogram), start(tsc_now()) {}
+
+		~latency_timer() {
+			histogram.record(tsc_now() - start);
+		}
+
+	private:
+		latency_histogram& histogram;
+		uint64_t start;
+};
+
+//passed to the rehash callbacks. pause_ns is 0 at the start
+struct rehash_event {
+	size_t old_capacity;
+	size_t new_capacity;
+	size_t size;
+	double pause_ns;
+};
+
+//instruments of one table. Copies of a table copy the histograms and callbacks
+struct table_stats {
+	latency_histogram inserts;
+	latency_histogram erases;
+	latency_histogram lookups;
+	latency_histogram rehashes;
+	std::function<void(const rehash_event&)> on_rehash_start;
+	std::function<void(const rehash_event&)> on_rehash_end;
+};
+
+//calls the rehash callbacks at construction and destruction and records the pause
+class rehash_timer {
+
+	public:
+		rehash_timer(table_stats& stats, size_t old_capacity, size_t new_capacity, size_t size)
+			: stats(stats), event{ old_capacity, new_capacity, size, 0 } {
+			if (stats.on_rehash_start)
+				stats.on_rehash_start(event);
+			start = tsc_now();
+		}
+
+		~rehash_timer() {
+			uint64_t ticks = tsc_now() - start;
+			stats.rehashes.record(ticks);
+			event.pause_ns = (double)ticks * tsc_ns_per_tick();
+			if (stats.on_rehash_end)
+				stats.on_rehash_end(event);
+		}
+
+	private:
+		table_stats& stats;
+		rehash_event event;
+		uint64_t start;
+};
+
+#ifdef HASHTABLE_INSTRUMENTATION
+#define TABLE_STATS_MEMBER mutable table_stats instruments;
+#define TABLE_TIMER(histogram) latency_timer table_timer_(instruments.histogram)
+#define TABLE_REHASH_TIMER(old_capacity, new_capacity, size) rehash_timer table_rehash_timer_(instruments, old_capacity, new_capacity, size)
+#else
+#define TABLE_STATS_MEMBER
+#define TABLE_TIMER(histogram)
+#define TABLE_REHASH_TIMER(old_capacity, new_capacity, size)
+#endif
@@ -1,9 +1,29 @@
 #include "hashtable_sc.h"
 #include "hashtable_oa.h"
+#include "hashtable_oa_int.h"
+#include "hashtable_cuckoo.h"
+#include "hashtable_hopscotch.h"
+#include "hashtable_small.h"
+#include "hashtable_adaptive.h"
+#include "hashtable_persistent.h"
+#include "partitioned_set.h"
+#include "bulk_loader.h"
+#include "hashtable_string.h"
+#include "trace.h"
+#include "instrumentation.h"
+#include "workload.h"
+#include "cuckoo_filter.h"
+#include <atomic>
 #include <iostream>
 #include <memory>
 #include <string>
+#include <unordered_set>
 #include <iomanip>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
 using namespace std;
 
 //custom functor for testing collision handling
@@ -20,6 +40,45 @@ struct custom_int_compare{
 	}
 };
 
+//value that counts its copies, for testing that the tables move values instead of copying them
+struct copy_counted {
+	static size_t copies;
+	int key;
+
+	copy_counted(int key = 0) : key(key) {}
+	copy_counted(const copy_counted& other) : key(other.key) { copies++; }
+	copy_counted(copy_counted&& other) noexcept : key(other.key) {}
+	copy_counted& operator=(const copy_counted& other) { key = other.key; copies++; return *this; }
+	copy_counted& operator=(copy_counted&& other) noexcept { key = other.key; return *this; }
+
+	bool operator==(const copy_counted& other) const {
+		return key == other.key;
+	}
+};
+
+size_t copy_counted::copies = 0;
+
+//ordered key without a byte representation flood_guard can key, colliding keys stay in one chain
+struct tagged_key {
+	int id;
+
+	tagged_key(int id = 0) : id(id) {}
+
+	bool operator==(const tagged_key& other) const {
+		return id == other.id;
+	}
+
+	bool operator<(const tagged_key& other) const {
+		return id < other.id;
+	}
+};
+
+struct copy_counted_hash {
+	std::size_t operator()(const copy_counted& value) const {
+		return default_hash<int>()(value.key);
+	}
+};
+
 void print_header(string text){
 	cout << "+";
 	for(int i = 0; i < text.size() + 10; i++)
@@ -319,6 +378,385 @@ void test_custom_comp_functor_sc(){
 
 }
 
+void test_equal_operator_order_independent_sc(){
+	cout << "====  test case: comparing hashtables with different capacities and insertion orders ====\n" << endl;
+	cout << "inserting 1..5 into a hashtable with capacity 10 and 5..1 into one with capacity 20..." << endl;
+	hashtable_sc<int> ht1(10);
+	hashtable_sc<int> ht2(20);
+	hashtable_sc<int> ht3(10);
+	for(int i = 1; i <= 5; i++){
+		ht1.insert(i);
+		ht2.insert(6 - i);
+		ht3.insert(i + 1);
+	}
+	cout << "comparing...\n" << endl;
+	if(ht1 == ht2 && ht2 == ht1 && !(ht1 == ht3))
+		cout << "SUCCESS\n" << endl;
+	else
+		cout << "FAILED\n" << endl;
+}
+
+void test_set_algebra_sc(size_t capacity_b, execution_policy policy){
+	cout << "====  test case: merge, intersect, difference and is_subset ====\n" << endl;
+	cout << "a = [1..6] with capacity 10, b = [4..9] with capacity " << capacity_b << ", " << policy.threads << " thread(s)\n" << endl;
+	hashtable_sc<int> a(10);
+	hashtable_sc<int> b(capacity_b);
+	for(int i = 1; i <= 6; i++){
+		a.insert(i);
+		b.insert(i + 3);
+	}
+
+	hashtable_sc<int> merged = a;
+	merged.merge(b, policy);
+	hashtable_sc<int> intersection = a;
+	intersection.intersect(b, policy);
+	hashtable_sc<int> diff = a;
+	diff.difference(b, policy);
+	cout << "a merge b: " << merged << "a intersect b: " << intersection << "a difference b: " << diff << endl;
+
+	bool test_success = merged.size() == 9 && intersection.size() == 3 && diff.size() == 3;
+	for(int i = 1; i <= 9; i++){
+		if(!merged.contains(i)) test_success = false;
+		if(intersection.contains(i) != (i >= 4 && i <= 6)) test_success = false;
+		if(diff.contains(i) != (i <= 3)) test_success = false;
+	}
+	if(!intersection.is_subset(a, policy) || !intersection.is_subset(b, policy) || a.is_subset(b, policy))
+		test_success = false;
+
+	if(test_success)
+		cout << "SUCCESS\n" << endl;
+	else
+		cout << "FAILED\n" << endl;
+}
+
+void test_bloom_filter_sc(){
+	cout << "====  test case: contains() behind a Bloom filter ====\n" << endl;
+	cout << "inserting the even numbers below 2000, then erasing the ones below 1000..." << endl;
+	hashtable_sc<int> ht(10);
+	ht.enable_bloom_filter(0.01);
+	for(int i = 0; i < 2000; i += 2)
+		ht.insert(i);
+
+	bool test_success = true;
+	for(int i = 0; i < 2000; i++){
+		if(ht.contains(i) != (i % 2 == 0)) test_success = false;
+	}
+	for(int i = 0; i < 1000; i += 2)
+		ht.erase(i);
+	for(int i = 0; i < 2000; i++){
+		if(ht.contains(i) != (i % 2 == 0 && i >= 1000)) test_success = false;
+	}
+	cout << "size: " << ht.size() << endl;
+	cout << "expected 500\n" << endl;
+	if(ht.size() != 500) test_success = false;
+
+	if(test_success)
+		cout << "SUCCESS\n" << endl;
+	else
+		cout << "FAILED\n" << endl;
+}
+
+//inserts keys and checks that all of them are found afterwards
+template<typename T, typename K>
+bool insert_and_find_all(T& ht, const vector<K>& keys){
+	for(const K& key : keys)
+		ht.insert(key);
+	bool found = ht.size() == keys.size();
+	for(const K& key : keys){
+		if(!ht.contains(key)) found = false;
+	}
+	return found;
+}
+
+void test_flood_defense_sc(){
+	typedef flood_guard<int, custom_hash<int>, std::equal_to<int>> full_guard;
+	typedef flood_guard<long long, std::hash<long long>, std::equal_to<long long>> modulo_guard;
+	cout << "====  Test case: collision flooding escalates the hash function ====\n" << endl;
+
+	vector<int> colliding;
+	for(int i = 0; i < 5000; i++)
+		colliding.push_back(i);
+	hashtable_sc<int, custom_hash<int>> full(10);
+	bool full_ok = insert_and_find_all(full, colliding) && full.hash_mode() == full_guard::keyed;
+	cout << "5000 values with equal hashes: " << (full_ok ? "keyed hashing" : "not defended") << endl;
+
+	//identity hash, all keys are multiples of every capacity up to 10 * 2^20
+	vector<long long> multiples;
+	for(long long i = 0; i < 5000; i++)
+		multiples.push_back(i * 10 * (1 << 20));
+	hashtable_sc<long long, std::hash<long long>> modulo(10);
+	bool modulo_ok = insert_and_find_all(modulo, multiples) && modulo.hash_mode() != modulo_guard::plain;
+	cout << "5000 values with equal hashes modulo the capacity: " << (modulo_ok ? "seeded hashing" : "not defended") << endl;
+
+	vector<int> sequential;
+	for(int i = 0; i < 100000; i++)
+		sequential.push_back(i);
+	hashtable_sc<int> trusted(10);
+	bool trusted_ok = insert_and_find_all(trusted, sequential) && trusted.hash_mode() == flood_guard<int, default_hash<int>, std::equal_to<int>>::plain;
+	cout << "100000 sequential values: " << (trusted_ok ? "plain hashing" : "escalated") << endl << endl;
+
+	if(full_ok && modulo_ok && trusted_ok)
+		cout << "SUCCESS\n" << endl;
+	else
+		cout << "FAILED\n" << endl;
+}
+
+void test_move_semantics_sc(){
+	cout << "====  Test case: insert, emplace, rehash and move without copying values ====\n" << endl;
+	copy_counted::copies = 0;
+	hashtable_sc<copy_counted, copy_counted_hash> ht(10);
+	for(int i = 0; i < 1000; i++)
+		ht.insert(copy_counted(i));
+	for(int i = 1000; i < 2000; i++)
+		ht.emplace(i);
+	ht.emplace(5); //duplicate
+	bool found = true;
+	for(int i = 0; i < 2000; i++){
+		if(!ht.contains(copy_counted(i))) found = false;
+	}
+	for(int i = 0; i < 2000; i += 2)
+		ht.erase(copy_counted(i));
+	cout << "copies after 2000 inserts, 2000 lookups and 1000 erases: " << copy_counted::copies << endl;
+	bool no_copies = copy_counted::copies == 0 && found && ht.size() == 1000;
+
+	hashtable_sc<copy_counted, copy_counted_hash> copy(ht);
+	bool copied = copy_counted::copies == 1000 && copy.size() == 1000;
+	hashtable_sc<copy_counted, copy_counted_hash> moved(std::move(ht));
+	bool move_ok = copy_counted::copies == 1000 && moved.size() == 1000 && moved.contains(copy_counted(1)) && ht.empty();
+	ht.insert(copy_counted(7)); //the moved-from table stays usable
+	copy = std::move(moved);
+	move_ok = move_ok && ht.size() == 1 && copy.size() == 1000 && moved.empty();
+	cout << "copies after copy construction and two moves: " << copy_counted::copies << endl << endl;
+
+	//a moved-from table has no buckets, moves cannot throw, so a growing vector moves the tables
+	static_assert(std::is_nothrow_move_constructible<hashtable_sc<copy_counted, copy_counted_hash>>::value,
+		"moving a table must not throw");
+	move_ok = move_ok && moved.capacity() == 0 && moved.load_factor() == 0 && !moved.contains(copy_counted(1)) &&
+		moved.begin() == moved.end();
+	moved.erase(copy_counted(1));
+	std::vector<hashtable_sc<copy_counted, copy_counted_hash>> tables;
+	for(int i = 0; i < 10; i++){
+		tables.emplace_back(4);
+		tables.back().insert(copy_counted(i));
+	}
+	for(int i = 0; i < 10; i++){
+		if(tables[i].size() != 1 || !tables[i].contains(copy_counted(i))) move_ok = false;
+	}
+	if(copy_counted::copies != 1000) move_ok = false;
+
+	if(no_copies && copied && move_ok)
+		cout << "SUCCESS\n" << endl;
+	else
+		cout << "FAILED\n" << endl;
+}
+
+void test_node_handle_sc(){
+	typedef hashtable_sc<copy_counted, copy_counted_hash> table;
+	cout << "====  Test case: extract, insert and merge nodes between tables ====\n" << endl;
+	copy_counted::copies = 0;
+	table a(10), b(10);
+	for(int i = 0; i < 1000; i++)
+		a.emplace(i);
+	for(int i = 0; i < 1000; i += 2)
+		b.insert(a.extract(copy_counted(i)));
+	table::node_handle missing = a.extract(copy_counted(-1));
+	bool moved = a.size() == 500 && b.size() == 500 && !a.contains(copy_counted(0)) && b.contains(copy_counted(0)) && !missing;
+	cout << "sizes after moving the even values: " << a.size() << " and " << b.size() << endl;
+
+	//a duplicate stays in the handle
+	a.emplace(0);
+	table::node_handle node = a.extract(copy_counted(0));
+	bool duplicate = !b.insert(std::move(node)) && node && node.value().key == 0;
+	node.value().key = 5000; //not stored -> the value may change
+	duplicate = duplicate && b.insert(std::move(node)) && b.contains(copy_counted(5000)) && node.empty();
+
+	//b holds 0, 2, .., 998 and 5000, a holds the odd values and 2000
+	for(int i = 0; i < 10; i++)
+		b.emplace(i);
+	a.emplace(2000);
+	a.merge(std::move(b));
+	cout << "sizes after merge: " << a.size() << " and " << b.size() << endl;
+	cout << "copies: " << copy_counted::copies << endl << endl;
+	bool merged = a.size() == 1002 && b.size() == 5 && a.contains(copy_counted(998)) && a.contains(copy_counted(5000));
+	for(int i = 1; i < 10; i += 2){
+		if(!b.contains(copy_counted(i))) merged = false; //duplicates remain in b
+	}
+
+	if(moved && duplicate && merged && copy_counted::copies == 0)
+		cout << "SUCCESS\n" << endl;
+	else
+		cout << "FAILED\n" << endl;
+}
+
+void test_erase_if_sc(execution_policy policy){
+	cout << "====  Test case: erase_if with " << policy.threads << " thread(s) ====\n" << endl;
+	hashtable_sc<int> ht(10);
+	for(int i = 0; i < 20000; i++)
+		ht.insert(i);
+	for(int i = 0; i < 20000; i += 7)
+		ht.erase(i);
+	size_t erased = ht.erase_if([](int value){ return value % 3 == 0; }, policy);
+	//every third value except the ones already erased (multiples of 21)
+	size_t expected = 20000 / 3 + 1 - (20000 / 21 + 1);
+	cout << "erased " << erased << " values, expected " << expected << endl;
+
+	bool test_success = erased == expected;
+	for(int i = 0; i < 20000; i++){
+		if(ht.contains(i) != (i % 7 != 0 && i % 3 != 0)) test_success = false;
+	}
+	size_t iterated = 0;
+	for(int value : ht){
+		(void)value;
+		iterated++;
+	}
+	if(iterated != ht.size()) test_success = false;
+
+	//long probe sequences and chains
+	hashtable_sc<int, custom_hash<int>> colliding(256);
+	for(int i = 0; i < 150; i++)
+		colliding.insert(i);
+	erased = colliding.erase_if([](int value){ return value % 2 == 0; }, policy);
+	for(int i = 0; i < 150; i++){
+		if(colliding.contains(i) != (i % 2 == 1)) test_success = false;
+	}
+	cout << "erased " << erased << " of 150 colliding values, expected 75" << endl << endl;
+	if(erased != 75 || colliding.size() != 75) test_success = false;
+
+	if(test_success)
+		cout << "SUCCESS\n" << endl;
+	else
+		cout << "FAILED\n" << endl;
+}
+
+void test_treeify_sc(){
+	typedef hashtable_sc<tagged_key, custom_hash<tagged_key>> table;
+	cout << "====  Test case: long chains of equal hashes are treeified ====\n" << endl;
+	table ht(16);
+	for(int i = 0; i < 5000; i++){
+		if(i % 2 == 0)
+			ht.insert(tagged_key(i));
+		else
+			ht.emplace(i);
+	}
+	cout << "5000 values with equal hashes, treeified buckets: " << ht.treeified_buckets() << endl;
+	bool test_success = ht.size() == 5000 && ht.treeified_buckets() == 1;
+	for(int i = 0; i < 6000; i++){
+		if(ht.contains(tagged_key(i)) != (i < 5000)) test_success = false;
+	}
+
+	//erase, node handles and set algebra keep the tree in step with the chain
+	for(int i = 0; i < 5000; i += 2)
+		ht.erase(tagged_key(i));
+	table::node_handle node = ht.extract(tagged_key(1));
+	node.value().id = 10001;
+	ht.insert(std::move(node));
+	table odd(16);
+	for(int i = 3; i < 1000; i += 2)
+		odd.insert(tagged_key(i));
+	ht.difference(odd);
+	ht.erase_if([](const tagged_key& key){ return key.id % 3 == 0; });
+	size_t expected = 0;
+	for(int i = 0; i < 11000; i++){
+		bool stored = (i >= 1000 && i < 5000 && i % 2 == 1 && i % 3 != 0) || i == 10001;
+		if(ht.contains(tagged_key(i)) != stored) test_success = false;
+		expected += stored;
+	}
+	if(ht.size() != expected) test_success = false;
+
+	//copies share capacity and hash, their set algebra compares tree against tree
+	table subset(ht);
+	for(int i = 1001; i < 3000; i += 2)
+		subset.erase(tagged_key(i));
+	table both(ht), rest(ht), target(subset), source(ht);
+	both.intersect(subset, par(4));
+	rest.difference(subset, par(4));
+	bool algebra_ok = subset.is_subset(ht, par(4)) && !ht.is_subset(subset) && both.equals(subset) && rest.size() == ht.size() - subset.size();
+	rest.merge(subset);
+	target.merge(std::move(source));
+	algebra_ok = algebra_ok && rest.equals(ht) && target.equals(ht) && source.size() == subset.size();
+	cout << "set algebra on treeified buckets: " << (algebra_ok ? "correct" : "wrong") << endl;
+	if(!algebra_ok) test_success = false;
+
+	//the copy builds its own tree
+	table copy(ht);
+	table assigned(16);
+	assigned = copy;
+	ht.clear();
+	if(copy.treeified_buckets() != 1 || !copy.contains(tagged_key(10001)) || !assigned.contains(tagged_key(1001)) || assigned.size() != expected) test_success = false;
+
+	//below UNTREEIFY_THRESHOLD the tree is dropped
+	for(int i = 1000; i < 5000; i++){
+		if(copy.size() > 5)
+			copy.erase(tagged_key(i));
+	}
+	cout << "after erasing all but 5 values: " << copy.treeified_buckets() << endl;
+	if(copy.treeified_buckets() != 0 || copy.size() != 5 || !copy.contains(tagged_key(10001))) test_success = false;
+
+	//without operator< the values of equal hash are searched with the comparator
+	hashtable_sc<copy_counted, custom_hash<copy_counted>> unordered(16);
+	for(int i = 0; i < 100; i++)
+		unordered.emplace(i);
+	bool unordered_ok = unordered.treeified_buckets() == 1;
+	for(int i = 0; i < 97; i++)
+		unordered.erase(copy_counted(i));
+	unordered_ok = unordered_ok && unordered.treeified_buckets() == 0 && unordered.contains(copy_counted(99)) && !unordered.contains(copy_counted(5));
+	cout << "values without operator<: " << (unordered_ok ? "found" : "not found") << endl << endl;
+
+	if(test_success && unordered_ok)
+		cout << "SUCCESS\n" << endl;
+	else
+		cout << "FAILED\n" << endl;
+}
+
+//partitions must cover every value exactly once, for_each must visit every value once
+template<typename T>
+void test_partitions(const string& description){
+	cout << "====  Test case: partitions and parallel for_each, " << description << " ====\n" << endl;
+	T ht(10);
+	bool test_success = true;
+	for(size_t n : { 1, 3, 8 }){
+		auto parts = ht.partitions(n);
+		for(const auto& part : parts){
+			if(!part.empty()) test_success = false; //empty table
+		}
+	}
+	for(int i = 0; i < 30000; i++)
+		ht.insert(i);
+
+	auto parts = ht.partitions(8);
+	vector<int> seen(30000, 0);
+	size_t largest = 0;
+	for(const auto& part : parts){
+		size_t n = 0;
+		for(int value : part){
+			seen[value]++;
+			n++;
+		}
+		largest = max(largest, n);
+	}
+	cout << "8 partitions, largest has " << largest << " of 30000 values" << endl;
+	for(int n : seen){
+		if(n != 1) test_success = false;
+	}
+	if(parts.size() != 8 || largest > 30000 / 8 * 2) test_success = false;
+
+	atomic<long long> sum(0);
+	atomic<size_t> visited(0);
+	ht.for_each(par(4), [&](int value){
+		sum += value;
+		visited++;
+	});
+	long long sequential_sum = 0;
+	ht.for_each(seq, [&](int value){ sequential_sum += value; });
+	cout << "for_each visited " << visited << " values" << endl << endl;
+	long long expected = 30000LL * 29999 / 2;
+	if(visited != 30000 || sum != expected || sequential_sum != expected) test_success = false;
+
+	if(test_success)
+		cout << "SUCCESS\n" << endl;
+	else
+		cout << "FAILED\n" << endl;
+}
 
 // OPEN ADDRESSING UNIT TESTS ============================================================================
 
@@ -629,111 +1067,1809 @@ void test_skip_deleted_value_oa(){
 }
 
 
+void test_equal_operator_order_independent_oa(){
+	cout << "====  test case: comparing hashtables with different capacities and insertion orders ====\n" << endl;
+	cout << "inserting 1..5 into a hashtable with capacity 10 and 5..1 into one with capacity 20..." << endl;
+	hashtable_oa<int> ht1(10);
+	hashtable_oa<int> ht2(20);
+	hashtable_oa<int> ht3(10);
+	for(int i = 1; i <= 5; i++){
+		ht1.insert(i);
+		ht2.insert(6 - i);
+		ht3.insert(i + 1);
+	}
+	cout << "comparing...\n" << endl;
+	if(ht1 == ht2 && ht2 == ht1 && !(ht1 == ht3))
+		cout << "SUCCESS\n" << endl;
+	else
+		cout << "FAILED\n" << endl;
+}
+
+void test_set_algebra_oa(size_t capacity_b, execution_policy policy){
+	cout << "====  test case: merge, intersect, difference and is_subset ====\n" << endl;
+	cout << "a = [1..6] with capacity 10, b = [4..9] with capacity " << capacity_b << ", " << policy.threads << " thread(s)\n" << endl;
+	hashtable_oa<int> a(10);
+	hashtable_oa<int> b(capacity_b);
+	for(int i = 1; i <= 6; i++){
+		a.insert(i);
+		b.insert(i + 3);
+	}
 
+	hashtable_oa<int> merged = a;
+	merged.merge(b);
+	hashtable_oa<int> intersection = a;
+	intersection.intersect(b, policy);
+	hashtable_oa<int> diff = a;
+	diff.difference(b, policy);
+	cout << "a merge b: " << merged << "a intersect b: " << intersection << "a difference b: " << diff << endl;
+
+	bool test_success = merged.size() == 9 && intersection.size() == 3 && diff.size() == 3;
+	for(int i = 1; i <= 9; i++){
+		if(!merged.contains(i)) test_success = false;
+		if(intersection.contains(i) != (i >= 4 && i <= 6)) test_success = false;
+		if(diff.contains(i) != (i <= 3)) test_success = false;
+	}
+	if(!intersection.is_subset(a, policy) || !intersection.is_subset(b, policy) || a.is_subset(b, policy))
+		test_success = false;
 
-int main() {		
+	if(test_success)
+		cout << "SUCCESS\n" << endl;
+	else
+		cout << "FAILED\n" << endl;
+}
 
-	print_header("SEPARATE CHAINING");
-	{
-		shared_ptr<hashtable_sc<int>> ht = make_shared<hashtable_sc<int>>(10);
-		test_queries_sc(ht, 10, 5);
+void test_bloom_filter_oa(){
+	cout << "====  test case: contains() behind a Bloom filter ====\n" << endl;
+	cout << "inserting the even numbers below 2000, then erasing the ones below 1000..." << endl;
+	hashtable_oa<int> ht(10);
+	ht.enable_bloom_filter(0.01);
+	for(int i = 0; i < 2000; i += 2)
+		ht.insert(i);
+
+	bool test_success = true;
+	for(int i = 0; i < 2000; i++){
+		if(ht.contains(i) != (i % 2 == 0)) test_success = false;
 	}
-	{
-		shared_ptr<hashtable_sc<int>> ht = make_shared<hashtable_sc<int>>(10);
-		test_insert_sc(ht, 5);
+	for(int i = 0; i < 1000; i += 2)
+		ht.erase(i);
+	for(int i = 0; i < 2000; i++){
+		if(ht.contains(i) != (i % 2 == 0 && i >= 1000)) test_success = false;
 	}
+	cout << "size: " << ht.size() << endl;
+	cout << "expected 500\n" << endl;
+	if(ht.size() != 500) test_success = false;
 
-	{
-		shared_ptr<hashtable_sc<int>> ht = make_shared<hashtable_sc<int>>(10);
-		test_insert_duplicates_sc(ht, 42);
+	if(test_success)
+		cout << "SUCCESS\n" << endl;
+	else
+		cout << "FAILED\n" << endl;
+}
+
+void test_flood_defense_oa(){
+	typedef flood_guard<int, custom_hash<int>, std::equal_to<int>> full_guard;
+	typedef flood_guard<long long, std::hash<long long>, std::equal_to<long long>> modulo_guard;
+	cout << "====  Test case: collision flooding escalates the hash function ====\n" << endl;
+
+	vector<int> colliding;
+	for(int i = 0; i < 5000; i++)
+		colliding.push_back(i);
+	hashtable_oa<int, custom_hash<int>> full(10);
+	bool full_ok = insert_and_find_all(full, colliding) && full.hash_mode() == full_guard::keyed;
+	cout << "5000 values with equal hashes: " << (full_ok ? "keyed hashing" : "not defended") << endl;
+
+	vector<long long> multiples;
+	for(long long i = 0; i < 5000; i++)
+		multiples.push_back(i * 10 * (1 << 20));
+	hashtable_oa<long long, std::hash<long long>> modulo(10);
+	bool modulo_ok = insert_and_find_all(modulo, multiples) && modulo.hash_mode() != modulo_guard::plain;
+	cout << "5000 values with equal hashes modulo the capacity: " << (modulo_ok ? "seeded hashing" : "not defended") << endl;
+
+	vector<int> sequential;
+	for(int i = 0; i < 100000; i++)
+		sequential.push_back(i);
+	hashtable_oa<int> trusted(10);
+	bool trusted_ok = insert_and_find_all(trusted, sequential) && trusted.hash_mode() == flood_guard<int, default_hash<int>, std::equal_to<int>>::plain;
+	cout << "100000 sequential values: " << (trusted_ok ? "plain hashing" : "escalated") << endl;
+
+	hashtable_oa<int> reseeded(10);
+	insert_and_find_all(reseeded, sequential);
+	reseeded.reseed();
+	bool reseed_ok = reseeded.size() == sequential.size() && reseeded.contains(4711) && !reseeded.contains(-1);
+	cout << "reseed keeps all values: " << (reseed_ok ? "yes" : "no") << endl;
+
+	//insert and erase churn leaves deleted slots, they must not escalate trusted keys
+	hashtable_oa<int> churned(4096);
+	bool churn_ok = true;
+	for(int i = 0; i < 400000; i++){
+		churned.insert(i);
+		if(i >= 1000)
+			churned.erase(i - 1000);
 	}
-	{
-		shared_ptr<hashtable_sc<int>> ht = make_shared<hashtable_sc<int>>(10);
-		int test_values[5] = { 1,2,3,4,5 };
-		test_clear_sc(ht, test_values);
+	for(int i = 399000; i < 400000; i++){
+		if(!churned.contains(i)) churn_ok = false;
 	}
-	{
-		shared_ptr<hashtable_sc<int>> ht = make_shared<hashtable_sc<int>>(10);
-		test_queries_sc(ht, 10, 4);
+	churn_ok = churn_ok && churned.size() == 1000 && churned.hash_mode() == flood_guard<int, default_hash<int>, std::equal_to<int>>::plain;
+	cout << "400000 inserts and erases: " << (churn_ok ? "plain hashing" : "escalated") << endl << endl;
+
+	if(full_ok && modulo_ok && trusted_ok && reseed_ok && churn_ok)
+		cout << "SUCCESS\n" << endl;
+	else
+		cout << "FAILED\n" << endl;
+}
+
+void test_move_semantics_oa(){
+	cout << "====  Test case: insert, emplace, rehash and move without copying values ====\n" << endl;
+	copy_counted::copies = 0;
+	hashtable_oa<copy_counted, copy_counted_hash> ht(10);
+	for(int i = 0; i < 1000; i++)
+		ht.insert(copy_counted(i));
+	for(int i = 1000; i < 2000; i++)
+		ht.emplace(i);
+	ht.emplace(5); //duplicate
+	bool found = true;
+	for(int i = 0; i < 2000; i++){
+		if(!ht.contains(copy_counted(i))) found = false;
 	}
-	{
-		shared_ptr<hashtable_sc<int>> ht = make_shared<hashtable_sc<int>>(10);
-		test_erase_sc(ht, 5, 6, 7);
+	for(int i = 0; i < 2000; i += 2)
+		ht.erase(copy_counted(i));
+	cout << "copies after 2000 inserts, 2000 lookups and 1000 erases: " << copy_counted::copies << endl;
+	bool no_copies = copy_counted::copies == 0 && found && ht.size() == 1000;
+
+	//the slot vector is copied as a whole, empty slots included
+	size_t slots = ht.capacity();
+	hashtable_oa<copy_counted, copy_counted_hash> copy(ht);
+	bool copied = copy_counted::copies == slots && copy.size() == 1000;
+	hashtable_oa<copy_counted, copy_counted_hash> moved(std::move(ht));
+	bool move_ok = copy_counted::copies == slots && moved.size() == 1000 && moved.contains(copy_counted(1)) && ht.empty();
+	ht.insert(copy_counted(7)); //the moved-from table stays usable
+	copy = std::move(moved);
+	move_ok = move_ok && ht.size() == 1 && copy.size() == 1000 && moved.empty();
+	cout << "copies after copy construction and two moves: " << copy_counted::copies << endl;
+
+	//a moved-from table has no slots, moves cannot throw, so a growing vector moves the tables
+	static_assert(std::is_nothrow_move_constructible<hashtable_oa<copy_counted, copy_counted_hash>>::value,
+		"moving a table must not throw");
+	move_ok = move_ok && moved.capacity() == 0 && moved.load_factor() == 0 && !moved.contains(copy_counted(1)) &&
+		moved.begin() == moved.end();
+	moved.erase(copy_counted(1));
+	std::vector<hashtable_oa<copy_counted, copy_counted_hash>> tables;
+	for(int i = 0; i < 10; i++){
+		tables.emplace_back(4);
+		tables.back().insert(copy_counted(i));
 	}
-	{
-		shared_ptr<hashtable_sc<int>> ht = make_shared<hashtable_sc<int>>(10);
-		test_erase_nonexistent_value_sc(ht, 1,2,3);
+	for(int i = 0; i < 10; i++){
+		if(tables[i].size() != 1 || !tables[i].contains(copy_counted(i))) move_ok = false;
 	}
-	{
-		shared_ptr<hashtable_sc<int>> ht = make_shared<hashtable_sc<int>>(10);
-		int rehash_test_values[10] = { 0,1,2,3,4,5,6,7,8,9 };
-		test_rehash_sc(ht, rehash_test_values, 10);
+	if(copy_counted::copies != slots) move_ok = false;
+	copy.clear();
+	bool cleared = copy.empty() && !copy.contains(copy_counted(1)) && copy.begin() == copy.end();
+	cout << "contains() and iteration after clear(): " << (cleared ? "empty" : "values left") << endl << endl;
+
+	if(no_copies && copied && move_ok && cleared)
+		cout << "SUCCESS\n" << endl;
+	else
+		cout << "FAILED\n" << endl;
+}
+
+void test_erase_if_oa(execution_policy policy){
+	cout << "====  Test case: erase_if with " << policy.threads << " thread(s) ====\n" << endl;
+	hashtable_oa<int> ht(10);
+	for(int i = 0; i < 20000; i++)
+		ht.insert(i);
+	for(int i = 0; i < 20000; i += 7)
+		ht.erase(i);
+	size_t erased = ht.erase_if([](int value){ return value % 3 == 0; }, policy);
+	//every third value except the ones already erased (multiples of 21)
+	size_t expected = 20000 / 3 + 1 - (20000 / 21 + 1);
+	cout << "erased " << erased << " values, expected " << expected << endl;
+
+	bool test_success = erased == expected;
+	for(int i = 0; i < 20000; i++){
+		if(ht.contains(i) != (i % 7 != 0 && i % 3 != 0)) test_success = false;
 	}
-	{
-		shared_ptr<hashtable_sc<int>> ht = make_shared<hashtable_sc<int>>(10);
-		int test_values[5] = { 1,2,3,4,5 };
-		test_iterator_sc(ht, test_values, 5);
+	size_t iterated = 0;
+	for(int value : ht){
+		(void)value;
+		iterated++;
 	}
-	{
-		shared_ptr<hashtable_sc<int>> ht = make_shared<hashtable_sc<int>>(10);
-		shared_ptr<hashtable_sc<int>> ht2 = make_shared<hashtable_sc<int>>(10);
-		int test_values[5] = { 1,2,3,4,5 };
-		test_equal_operator_sc(ht, ht2, test_values, 5);
+	if(iterated != ht.size()) test_success = false;
+
+	//long probe sequences and chains
+	hashtable_oa<int, custom_hash<int>> colliding(256);
+	for(int i = 0; i < 150; i++)
+		colliding.insert(i);
+	erased = colliding.erase_if([](int value){ return value % 2 == 0; }, policy);
+	for(int i = 0; i < 150; i++){
+		if(colliding.contains(i) != (i % 2 == 1)) test_success = false;
 	}
-	test_custom_hash_functor_sc();
-	test_custom_comp_functor_sc();
+	cout << "erased " << erased << " of 150 colliding values, expected 75" << endl << endl;
+	if(erased != 75 || colliding.size() != 75) test_success = false;
 
+	if(test_success)
+		cout << "SUCCESS\n" << endl;
+	else
+		cout << "FAILED\n" << endl;
+}
 
+void test_cache_oa(){
+	cout << "====  Test case: bounded cache mode with CLOCK eviction ====\n" << endl;
+	hashtable_oa<int> ht(10);
+	unordered_set<int> reference;
+	ht.on_evict([&](int&& value){ reference.erase(value); });
+	ht.enable_cache(1000);
+	size_t slots = ht.capacity();
+
+	//hot keys are looked up between the inserts and keep their reference bit
+	bool test_success = true;
+	unsigned state = 12345;
+	for(int i = 0; i < 100000; i++){
+		state = state * 1103515245 + 12345;
+		int key = 100 + (int)((state >> 8) % 50000);
+		if(state % 5 == 0){
+			ht.erase(key);
+			reference.erase(key);
+		} else {
+			ht.insert(key);
+			reference.insert(key);
+		}
+		for(int hot = 0; hot < 10 && i >= 10; hot++){
+			if(!ht.contains(hot)) test_success = false;
+		}
+		if(i < 10){
+			ht.insert(i);
+			reference.insert(i);
+		}
+		if(ht.size() > 1000 || ht.capacity() != slots) test_success = false;
+	}
+	cout << ht.size() << " values in " << ht.capacity() << " slots, " << ht.cache_evictions() << " evictions, "
+		<< ht.cache_hits() << " hits, " << ht.cache_misses() << " misses" << endl;
 
-	//----------------------------------------------------------------------
+	//evicted values were reported, the shifted ones are still found
+	if(ht.size() != reference.size() || ht.size() != 1000) test_success = false;
+	for(int value : reference){
+		if(!ht.contains(value)) test_success = false;
+	}
+	if(ht.cache_misses() != 0 || ht.cache_hits() < 10 * 99990) test_success = false;
+	ht.contains(-1);
+	if(ht.cache_misses() != 1) test_success = false;
+
+	//shrinking a filled table evicts the surplus, a byte budget bounds the slot array
+	ht.enable_cache(100);
+	hashtable_oa<string> strings(10);
+	strings.enable_cache_bytes(64 * 1024);
+	for(int i = 0; i < 10000; i++)
+		strings.insert(to_string(i));
+	cout << "after shrinking " << ht.size() << " values, reported " << reference.size() << endl;
+	cout << "64 KB budget: " << strings.size() << " strings in " << strings.capacity() << " slots of "
+		<< sizeof(hashtable_oa<string>::Entry) << " bytes" << endl;
+	if(ht.size() != 100 || reference.size() != 100 || strings.size() != strings.max_size() ||
+		strings.capacity() * sizeof(hashtable_oa<string>::Entry) > 64 * 1024 || !strings.contains("9999")) test_success = false;
+
+	//a cache as the other table: the union is complete, its limit and statistics stay untouched
+	size_t evictions = ht.cache_evictions(), hits = ht.cache_hits(), reported = reference.size();
+	hashtable_oa<int> small(10);
+	for(int i = -10; i < 0; i++)
+		small.insert(i);
+	small.merge(ht);
+	hashtable_oa<int> intersected(small);
+	intersected.intersect(ht, par(4));
+	cout << "union with the cache: " << small.size() << " values, intersection: " << intersected.size() << endl << endl;
+	if(small.size() != 110 || intersected.size() != 100 || !small.contains(-1) || ht.cache_evictions() != evictions ||
+		ht.cache_hits() != hits || reference.size() != reported) test_success = false;
+
+	//a cache as this table: the values are removed without leaving deleted slots
+	hashtable_oa<int> even(10);
+	for(int value : reference){
+		if(value % 2 == 0) even.insert(value);
+	}
+	for(int i = -200; i < 0; i++)
+		even.insert(i);
+	hashtable_oa<int> kept(ht), dropped(ht);
+	kept.intersect(even, par(4));
+	dropped.difference(even, par(4));
+	cout << "cache intersect even: " << kept.size() << " values, difference: " << dropped.size() << endl << endl;
+	if(kept.size() + dropped.size() != 100 || kept.deleted_slots() != 0 || dropped.deleted_slots() != 0)
+		test_success = false;
+	for(int value : reference){
+		if(kept.contains(value) != (value % 2 == 0) || dropped.contains(value) != (value % 2 != 0)) test_success = false;
+	}
 
-	print_header("OPEN ADDRESSING");
-	{
-		shared_ptr<hashtable_oa<int>> ht = make_shared<hashtable_oa<int>>(10);
-		test_queries_oa(ht, 10, 5);
+	if(test_success)
+		cout << "SUCCESS\n" << endl;
+	else
+		cout << "FAILED\n" << endl;
+}
+
+void test_blocked_bloom_filter(){
+	cout << "====  test case: false positive rate of the blocked Bloom filter ====\n" << endl;
+	cout << "adding 10000 keys with a target rate of 1%, querying 100000 other keys..." << endl;
+	blocked_bloom_filter filter(10000, 0.01);
+	std::hash<int> hash;
+	for(int i = 0; i < 10000; i++)
+		filter.add(hash(i));
+
+	bool test_success = true;
+	for(int i = 0; i < 10000; i++){
+		if(!filter.may_contain(hash(i))) test_success = false; //no false negatives
 	}
-	{
-		shared_ptr<hashtable_oa<int>> ht = make_shared<hashtable_oa<int>>(10);
-		test_insert_oa(ht, 5);
+	int false_positives = 0;
+	for(int i = 10000; i < 110000; i++){
+		if(filter.may_contain(hash(i))) false_positives++;
 	}
+	double rate = false_positives / 100000.0;
+	cout << "measured false positive rate: " << rate << endl;
+	cout << "memory: " << filter.memory() << " bytes\n" << endl;
+	if(rate > 0.02) test_success = false;
 
-	{
-		shared_ptr<hashtable_oa<int>> ht = make_shared<hashtable_oa<int>>(10);
-		test_insert_duplicates_oa(ht, 42);
+	blocked_bloom_filter limited(10000, 0.01, 1024);
+	if(limited.memory() > 1024) test_success = false;
+
+	if(test_success)
+		cout << "SUCCESS\n" << endl;
+	else
+		cout << "FAILED\n" << endl;
+}
+
+// CUCKOO HASHING UNIT TESTS ============================================================================
+
+void test_insert_erase_cuckoo(){
+	cout << "====  Test case: insert and erase values (includes contains()) ====\n" << endl;
+	cout << "inserting 0..999, erasing the odd values..." << endl;
+	hashtable_cuckoo<int> ht(10);
+	for(int i = 0; i < 1000; i++)
+		ht.insert(i);
+	for(int i = 0; i < 1000; i++)
+		ht.insert(i); //duplicates are rejected
+	for(int i = 1; i < 1000; i += 2)
+		ht.erase(i);
+
+	bool test_success = ht.size() == 500;
+	for(int i = 0; i < 1000; i++){
+		if(ht.contains(i) != (i % 2 == 0)) test_success = false;
 	}
-	{
-		shared_ptr<hashtable_oa<int>> ht = make_shared<hashtable_oa<int>>(10);
-		int test_values[5] = { 1,2,3,4,5 };
-		test_clear_oa(ht, test_values);
+	cout << "size: " << ht.size() << endl;
+	cout << "expected 500\n" << endl;
+
+	if(test_success)
+		cout << "SUCCESS\n" << endl;
+	else
+		cout << "FAILED\n" << endl;
+}
+
+void test_high_load_cuckoo(){
+	cout << "====  Test case: load factor reached before the first rehash ====\n" << endl;
+	hashtable_cuckoo<int> ht(4096);
+	double max_load = 0;
+	int i = 0;
+	while(ht.capacity() == 4096){
+		max_load = ht.load_factor();
+		ht.insert(i++);
 	}
-	{
-		shared_ptr<hashtable_oa<int>> ht = make_shared<hashtable_oa<int>>(10);
-		test_erase_oa(ht, 5, 6, 7);
+	cout << "load factor before growing: " << max_load << endl;
+	cout << "expected > 0.9\n" << endl;
+
+	bool test_success = max_load > 0.9;
+	for(int j = 0; j < i; j++){
+		if(!ht.contains(j)) test_success = false;
 	}
-	{
-		shared_ptr<hashtable_oa<int>> ht = make_shared<hashtable_oa<int>>(10);
-		test_erase_nonexistent_value_oa(ht, 1, 2, 3);
+
+	if(test_success)
+		cout << "SUCCESS\n" << endl;
+	else
+		cout << "FAILED\n" << endl;
+}
+
+void test_collision_handling_cuckoo(){
+	cout << "====  test case: causing collisions with a custom hash functor ====\n" << endl;
+	cout << "the table switches to keyed hashing once the stash is full\n" << endl;
+	hashtable_cuckoo<int, custom_hash<int>> ht(10);
+	for(int i = 0; i < 2000; i++)
+		ht.insert(i);
+	ht.erase(3);
+
+	bool test_success = ht.size() == 1999 && !ht.contains(3) && ht.stash_size() <= ht.STASH_SIZE;
+	test_success = test_success && ht.hash_mode() == flood_guard<int, custom_hash<int>, std::equal_to<int>>::keyed;
+	for(int i = 0; i < 2000; i++){
+		if(i != 3 && !ht.contains(i)) test_success = false;
 	}
-	{
-		shared_ptr<hashtable_oa<int>> ht = make_shared<hashtable_oa<int>>(10);
-		int rehash_test_values[10] = { 0,1,2,3,4,5,6,7,8,9 };
-		test_rehash_oa(ht, rehash_test_values, 10);
+	cout << "stash size: " << ht.stash_size() << endl;
+
+	//no hash separates values of a type that cannot be keyed, the stash takes them
+	hashtable_cuckoo<tagged_key, custom_hash<tagged_key>> constant(10);
+	for(int i = 0; i < 40; i++)
+		constant.insert(tagged_key(i));
+	constant.erase(tagged_key(3));
+	for(int i = 0; i < 40; i++){
+		if(constant.contains(tagged_key(i)) != (i != 3)) test_success = false;
 	}
-	
-	{
-		shared_ptr<hashtable_oa<int>> ht = make_shared<hashtable_oa<int>>(10);
-		int test_values[5] = { 1,2,3,4,5 };
-		test_iterator_oa(ht, test_values, 5);
+	cout << "stash size with a constant hash and no keyed hashing: " << constant.stash_size() << endl << endl;
+	if(constant.size() != 39) test_success = false;
+
+	if(test_success)
+		cout << "SUCCESS\n" << endl;
+	else
+		cout << "FAILED\n" << endl;
+}
+
+void test_iterator_cuckoo(){
+	cout << "====  test case: iterating and dereferencing using iterator ====\n" << endl;
+	hashtable_cuckoo<int> ht(10);
+	int sum = 0;
+	for(int i = 1; i <= 5; i++)
+		ht.insert(i);
+
+	cout << "Operator ++ post increment: ";
+	auto iter1 = ht.begin();
+	while(iter1 != ht.end()){
+		cout << *iter1 << " ";
+		sum += *iter1;
+		iter1++;
 	}
-	{
-		shared_ptr<hashtable_oa<int>> ht = make_shared<hashtable_oa<int>>(10);
-		shared_ptr<hashtable_oa<int>> ht2 = make_shared<hashtable_oa<int>>(10);
-		int test_values[5] = { 1,2,3,4,5 };
-		test_equal_operator_oa(ht, ht2, test_values, 5);
+	cout << endl;
+
+	cout << "Operator -- pre decrement: ";
+	auto iter2 = ht.end();
+	while(iter2 != ht.begin()){
+		--iter2;
+		cout << *iter2 << " ";
+		sum -= *iter2;
 	}
-	test_custom_hash_functor_oa();
-	test_custom_comp_functor_oa();
-	test_skip_deleted_value_oa();
+	cout << endl << endl;
+
+	if(sum == 0 && *ht.begin() != 0)
+		cout << "SUCCESS\n" << endl;
+	else
+		cout << "FAILED\n" << endl;
+}
+
+// HOPSCOTCH HASHING UNIT TESTS =========================================================================
+
+void test_insert_erase_hopscotch(){
+	cout << "====  Test case: insert and erase values (includes contains()) ====\n" << endl;
+	cout << "inserting 0..999, erasing the odd values..." << endl;
+	hashtable_hopscotch<int> ht(10);
+	for(int i = 0; i < 1000; i++)
+		ht.insert(i);
+	for(int i = 0; i < 1000; i++)
+		ht.insert(i); //duplicates are rejected
+	for(int i = 1; i < 1000; i += 2)
+		ht.erase(i);
+
+	bool test_success = ht.size() == 500;
+	for(int i = 0; i < 1000; i++){
+		if(ht.contains(i) != (i % 2 == 0)) test_success = false;
+	}
+	cout << "size: " << ht.size() << endl;
+	cout << "expected 500\n" << endl;
+
+	if(test_success)
+		cout << "SUCCESS\n" << endl;
+	else
+		cout << "FAILED\n" << endl;
+}
+
+void test_high_load_hopscotch(){
+	cout << "====  Test case: load factor reached before the first rehash ====\n" << endl;
+	hashtable_hopscotch<int> ht(4096);
+	double max_load = 0;
+	int i = 0;
+	while(ht.capacity() == 4096){
+		max_load = ht.load_factor();
+		ht.insert(i++);
+	}
+	cout << "load factor before growing: " << max_load << endl;
+	cout << "expected > 0.85\n" << endl;
+
+	bool test_success = max_load > 0.85;
+	for(int j = 0; j < i; j++){
+		if(!ht.contains(j)) test_success = false;
+	}
+
+	if(test_success)
+		cout << "SUCCESS\n" << endl;
+	else
+		cout << "FAILED\n" << endl;
+}
+
+void test_collision_handling_hopscotch(){
+	cout << "====  test case: causing collisions with a custom hash functor ====\n" << endl;
+	cout << "the table switches to keyed hashing once the overflow is full\n" << endl;
+	hashtable_hopscotch<int, custom_hash<int>> ht(100);
+	for(int i = 0; i < 2000; i++)
+		ht.insert(i);
+	ht.erase(3);
+	ht.erase(35);
+
+	bool test_success = ht.size() == 1998 && !ht.contains(3) && !ht.contains(35) && ht.overflow_size() <= ht.OVERFLOW_SIZE;
+	test_success = test_success && ht.hash_mode() == flood_guard<int, custom_hash<int>, std::equal_to<int>>::keyed;
+	int iterated = 0;
+	for(int value : ht){
+		iterated++;
+		if(!ht.contains(value)) test_success = false;
+	}
+	if(iterated != 1998) test_success = false;
+	cout << "overflow size: " << ht.overflow_size() << endl;
+
+	//no hash separates values of a type that cannot be keyed, the overflow takes them
+	hashtable_hopscotch<tagged_key, custom_hash<tagged_key>> constant(100);
+	for(int i = 0; i < 40; i++)
+		constant.insert(tagged_key(i));
+	constant.erase(tagged_key(3));
+	for(int i = 0; i < 40; i++){
+		if(constant.contains(tagged_key(i)) != (i != 3)) test_success = false;
+	}
+	cout << "overflow size with a constant hash and no keyed hashing: " << constant.overflow_size() << endl << endl;
+	if(constant.size() != 39) test_success = false;
+
+	if(test_success)
+		cout << "SUCCESS\n" << endl;
+	else
+		cout << "FAILED\n" << endl;
+}
+
+// SMALL SIZE UNIT TESTS ================================================================================
+
+void test_inline_storage_small(){
+	cout << "====  Test case: values stay inline up to the threshold ====\n" << endl;
+	cout << "inserting 1..8 into a set with 8 inline slots..." << endl;
+	hashtable_small<int> ht;
+	for(int i = 1; i <= 8; i++)
+		ht.insert(i);
+	ht.insert(8); //duplicates are rejected
+	cout << "contents: " << ht;
+	cout << "inline: " << ht.is_inline() << endl;
+	cout << "expected true\n" << endl;
+
+	bool test_success = ht.is_inline() && ht.size() == 8;
+	ht.erase(4);
+	for(int i = 1; i <= 8; i++){
+		if(ht.contains(i) != (i != 4)) test_success = false;
+	}
+	cout << "object size: " << sizeof(ht) << " bytes, no heap allocation" << endl << endl;
+
+	if(test_success)
+		cout << "SUCCESS\n" << endl;
+	else
+		cout << "FAILED\n" << endl;
+}
+
+void test_switch_to_table_small(){
+	cout << "====  Test case: switching to a hashtable beyond the threshold ====\n" << endl;
+	cout << "inserting 1..100, then clearing..." << endl;
+	hashtable_small<int> ht;
+	for(int i = 1; i <= 100; i++)
+		ht.insert(i);
+
+	bool test_success = !ht.is_inline() && ht.size() == 100;
+	int sum = 0;
+	for(int value : ht)
+		sum += value;
+	if(sum != 5050) test_success = false;
+
+	hashtable_small<int> copy = ht;
+	if(!(copy == ht)) test_success = false;
+
+	ht.clear();
+	if(!ht.is_inline() || !ht.empty() || copy.size() != 100) test_success = false;
+
+	if(test_success)
+		cout << "SUCCESS\n" << endl;
+	else
+		cout << "FAILED\n" << endl;
+}
+
+// STRING SET UNIT TESTS ================================================================================
+
+void test_heterogeneous_lookup_string(){
+	cout << "====  Test case: lookups with std::string, string_view and const char* ====\n" << endl;
+	hashtable_string<> ht(10);
+	ht.insert(string("apple"));
+	ht.insert(string_view("banana"));
+	ht.insert("cherry");
+	ht.insert("cherry"); //duplicates are rejected
+	ht.insert("");
+	cout << "contents of hashtable: " << ht << endl;
+
+	const char* text = "apple pie";
+	bool test_success = ht.size() == 4 &&
+		ht.contains(string_view(text, 5)) && //no std::string is built for the lookup
+		ht.contains(string("banana")) &&
+		ht.contains("cherry") &&
+		ht.contains("") &&
+		!ht.contains("apple pie") &&
+		!ht.contains("cherr");
+
+	ht.erase("banana");
+	if(ht.contains("banana") || ht.size() != 3) test_success = false;
+
+	if(test_success)
+		cout << "SUCCESS\n" << endl;
+	else
+		cout << "FAILED\n" << endl;
+}
+
+void test_arena_compaction_string(){
+	cout << "====  Test case: arena is compacted after many erases ====\n" << endl;
+	cout << "inserting 1000 strings, erasing 900 of them and inserting 1000 new ones..." << endl;
+	hashtable_string<> ht(10);
+	for(int i = 0; i < 1000; i++)
+		ht.insert("key" + to_string(i));
+	size_t arena_before = ht.arena_size();
+	for(int i = 0; i < 900; i++)
+		ht.erase("key" + to_string(i));
+	for(int i = 0; i < 1000; i++)
+		ht.insert("new" + to_string(i));
+
+	bool test_success = ht.size() == 1100;
+	for(int i = 0; i < 1000; i++){
+		if(ht.contains("key" + to_string(i)) != (i >= 900)) test_success = false;
+		if(!ht.contains("new" + to_string(i))) test_success = false;
+	}
+	int iterated = 0;
+	for(string_view item : ht){
+		iterated++;
+		if(!ht.contains(item)) test_success = false;
+	}
+	if(iterated != 1100) test_success = false;
+
+	cout << "arena size after the first 1000 inserts: " << arena_before << endl;
+	cout << "arena size at the end: " << ht.arena_size() << endl << endl;
+	if(ht.arena_size() >= 2 * arena_before) test_success = false;
+
+	if(test_success)
+		cout << "SUCCESS\n" << endl;
+	else
+		cout << "FAILED\n" << endl;
+}
+
+// INTEGRAL KEY UNIT TESTS ==============================================================================
+
+template<typename T>
+void test_random_operations_int(T& ht, const string& description){
+	cout << "====  Test case: random inserts and erases, " << description << " ====\n" << endl;
+	cout << "running 20000 random operations and comparing with a reference set..." << endl;
+	unordered_set<int> reference;
+	unsigned state = 12345;
+	for(int i = 0; i < 20000; i++){
+		state = state * 1103515245 + 12345;
+		int key = (state >> 8) % 2000;
+		if(state % 3 == 0){
+			ht.erase(key);
+			reference.erase(key);
+		} else {
+			ht.insert(key);
+			reference.insert(key);
+		}
+	}
+
+	bool test_success = ht.size() == reference.size();
+	for(int key = 0; key < 2000; key++){
+		if(ht.contains(key) != (reference.count(key) == 1)) test_success = false;
+	}
+	size_t iterated = 0;
+	for(int key : ht){
+		iterated++;
+		if(reference.count(key) == 0) test_success = false;
+	}
+	if(iterated != reference.size()) test_success = false;
+	cout << "size: " << ht.size() << endl;
+	cout << "expected " << reference.size() << "\n" << endl;
+
+	if(test_success)
+		cout << "SUCCESS\n" << endl;
+	else
+		cout << "FAILED\n" << endl;
+}
+
+void test_sentinels_int(){
+	cout << "====  Test case: sentinel keys are rejected ====\n" << endl;
+	hashtable_oa_int<int, -1, -2> ht(10);
+	ht.insert(-1);
+	ht.insert(-2);
+	ht.insert(7);
+	cout << "contents of hashtable: " << ht << endl;
+	if(ht.size() == 1 && !ht.contains(-1) && !ht.contains(-2) && ht.contains(7))
+		cout << "SUCCESS\n" << endl;
+	else
+		cout << "FAILED\n" << endl;
+}
+
+// HASHING UNIT TESTS ===================================================================================
+
+//largest deviation from 0.5 of the probability that an output bit flips when one input bit flips.
+//An ideal hash function gives 0 up to sampling noise
+template<typename F>
+double max_avalanche_bias(F hash, size_t input_bytes, size_t samples){
+	vector<vector<size_t>> flips(input_bytes * 8, vector<size_t>(64, 0));
+	unsigned char input[64];
+	uint64_t state = 88172645463325252ULL;
+	for(size_t s = 0; s < samples; s++){
+		for(size_t i = 0; i < input_bytes; i++){
+			state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+			input[i] = (unsigned char)state;
+		}
+		uint64_t h = hash(input, input_bytes);
+		for(size_t bit = 0; bit < input_bytes * 8; bit++){
+			input[bit / 8] ^= (unsigned char)(1 << (bit % 8));
+			uint64_t diff = h ^ hash(input, input_bytes);
+			input[bit / 8] ^= (unsigned char)(1 << (bit % 8));
+			for(size_t out = 0; out < 64; out++)
+				flips[bit][out] += (diff >> out) & 1;
+		}
+	}
+	double max_bias = 0;
+	for(auto& row : flips){
+		for(size_t count : row)
+			max_bias = max(max_bias, fabs((double)count / samples - 0.5));
+	}
+	return max_bias;
+}
+
+//chi-square statistic of the bucket counts of n keys in m buckets
+template<typename F>
+double bucket_chi_square(F hash_of_key, size_t n, size_t m){
+	vector<size_t> buckets(m, 0);
+	for(size_t i = 0; i < n; i++)
+		buckets[hash_of_key(i) % m]++;
+	double expected = (double)n / m, chi = 0;
+	for(size_t count : buckets)
+		chi += (count - expected) * (count - expected) / expected;
+	return chi;
+}
+
+void test_avalanche_hash(){
+	cout << "====  Test case: avalanche of mix64, default_hash and hash_bytes ====\n" << endl;
+	double bias_mix = max_avalanche_bias([](const unsigned char* p, size_t){
+		uint64_t v; memcpy(&v, p, 8); return mix64(v);
+	}, 8, 4000);
+	double bias_int = max_avalanche_bias([](const unsigned char* p, size_t){
+		uint32_t v; memcpy(&v, p, 4); return (uint64_t)default_hash<uint32_t>()(v);
+	}, 4, 4000);
+	double bias_short = max_avalanche_bias([](const unsigned char* p, size_t len){
+		return hash_bytes(p, len);
+	}, 11, 4000);
+	double bias_long = max_avalanche_bias([](const unsigned char* p, size_t len){
+		return hash_bytes(p, len);
+	}, 64, 4000);
+	cout << "max bias: mix64 " << bias_mix << ", default_hash<uint32_t> " << bias_int
+		<< ", hash_bytes 11 bytes " << bias_short << ", hash_bytes 64 bytes " << bias_long << endl;
+	//the sampling noise of 4000 samples has a standard deviation of 0.008
+	if(bias_mix < 0.05 && bias_int < 0.05 && bias_short < 0.05 && bias_long < 0.05)
+		cout << "SUCCESS\n" << endl;
+	else
+		cout << "FAILED\n" << endl;
+}
+
+void test_distribution_hash(){
+	cout << "====  Test case: bucket distribution of sequential, strided and string keys ====\n" << endl;
+	const size_t n = 1 << 16, m = 1 << 12;
+	double chi_sequential = bucket_chi_square([](size_t i){ return default_hash<int>()((int)i); }, n, m);
+	double chi_strided = bucket_chi_square([](size_t i){ return default_hash<int>()((int)(i * 4096)); }, n, m);
+	double chi_identity = bucket_chi_square([](size_t i){ return std::hash<int>()((int)(i * 4096)); }, n, m);
+	double chi_string = bucket_chi_square([](size_t i){ return default_hash<string>()("key" + to_string(i)); }, n, m);
+	double chi_pair = bucket_chi_square([](size_t i){ return (size_t)hash_values((int)(i % 256), (int)(i / 256)); }, n, m);
+	cout << "chi-square with " << m - 1 << " degrees of freedom: sequential " << chi_sequential
+		<< ", strided " << chi_strided << ", strided with std::hash " << chi_identity
+		<< ", strings " << chi_string << ", pairs " << chi_pair << endl;
+	//mean m - 1, standard deviation about sqrt(2m) -> accept up to 6 standard deviations
+	double limit = m + 6 * sqrt(2.0 * m);
+	if(chi_sequential < limit && chi_strided < limit && chi_string < limit && chi_pair < limit)
+		cout << "SUCCESS\n" << endl;
+	else
+		cout << "FAILED\n" << endl;
+}
+
+void test_hash_bytes_lengths(){
+	cout << "====  Test case: hash_bytes separates prefixes of every length ====\n" << endl;
+	string text(200, 'a');
+	unordered_set<uint64_t> hashes;
+	for(size_t len = 0; len <= text.size(); len++)
+		hashes.insert(hash_bytes(text.data(), len));
+	bool seeded = hash_bytes(text.data(), 20, 1) != hash_bytes(text.data(), 20, 2);
+	bool same_view = default_hash<string>()(text) == default_hash<string_view>()(string_view(text));
+	cout << "distinct hashes: " << hashes.size() << " of " << text.size() + 1 << endl;
+	if(hashes.size() == text.size() + 1 && seeded && same_view)
+		cout << "SUCCESS\n" << endl;
+	else
+		cout << "FAILED\n" << endl;
+}
+
+void test_siphash_reference(){
+	cout << "====  Test case: siphash matches the reference vectors ====\n" << endl;
+	unsigned char key[16], message[15];
+	for(int i = 0; i < 16; i++)
+		key[i] = (unsigned char)i;
+	for(int i = 0; i < 15; i++)
+		message[i] = (unsigned char)i;
+	uint64_t k0, k1;
+	memcpy(&k0, key, 8);
+	memcpy(&k1, key + 8, 8);
+	uint64_t empty = siphash(message, 0, k0, k1);
+	uint64_t full = siphash(message, 15, k0, k1);
+	cout << hex << "empty message: " << empty << ", 15 bytes: " << full << dec << endl;
+	if(empty == 0x726fdb47dd0e0e31ULL && full == 0xa129ca6149be45e5ULL)
+		cout << "SUCCESS\n" << endl;
+	else
+		cout << "FAILED\n" << endl;
+}
+
+// STORAGE UNIT TESTS ===================================================================================
+
+//entries of a cache line aligned array may not straddle two cache lines
+template<typename T>
+bool fits_cache_lines(){
+	return 64 % sizeof(T) == 0 || sizeof(T) % 64 == 0;
+}
+
+void test_control_scans(){
+	cout << "====  Test case: vectorized scans of control bytes ====\n" << endl;
+	bool test_success = true;
+	vector<unsigned char> ctrl(1000);
+	unsigned state = 777;
+	for(unsigned char& c : ctrl){
+		state = state * 1103515245 + 12345;
+		c = (state >> 16) % 97 == 0 ? 2 : 0;
+	}
+	for(size_t first = 0; first < 70; first++){
+		for(size_t last : { first, first + 1, first + 17, first + 33, (size_t)1000 }){
+			size_t found = first, found_not = first, counted = 0;
+			while(found < last && ctrl[found] != 2) found++;
+			while(found_not < last && ctrl[found_not] == 0) found_not++;
+			for(size_t i = first; i < last; i++)
+				counted += ctrl[i] == 2;
+			if(find_control(ctrl.data(), first, last, 2) != found || find_control_not(ctrl.data(), first, last, 0) != found_not ||
+				count_control(ctrl.data(), first, last, 2) != counted) test_success = false;
+		}
+	}
+
+	//sparse table: iteration in both directions and clear find every value
+	hashtable_oa<string> ht(10);
+	ht.rehash(100000);
+	for(int i = 0; i < 5000; i++)
+		ht.insert(to_string(i * 31));
+	size_t forward = 0, backward = 0;
+	for(auto it = ht.begin(); it != ht.end(); ++it)
+		forward++;
+	auto it = ht.end();
+	do {
+		--it;
+		if(ht.contains(*it)) backward++;
+	} while(it != ht.begin());
+	cout << "iterated " << forward << " values forward and " << backward << " backward in " << ht.capacity() << " slots" << endl;
+	ht.clear();
+	cout << "after clear: " << ht.size() << " values\n" << endl;
+	if(forward != 5000 || backward != 5000 || ht.begin() != ht.end() || ht.contains("0")) test_success = false;
+
+	if(test_success)
+		cout << "SUCCESS\n" << endl;
+	else
+		cout << "FAILED\n" << endl;
+}
+
+void test_page_storage(){
+	cout << "====  Test case: cache line aligned and page mapped slot arrays ====\n" << endl;
+	huge_page_allocator<uint64_t> allocator;
+	bool test_success = true;
+	for(size_t n : { (size_t)100, (size_t)1 << 20 }){
+		uint64_t* values = allocator.allocate(n);
+		for(size_t i = 0; i < n; i++)
+			values[i] = i;
+		for(size_t i = 0; i < n; i++){
+			if(values[i] != i) test_success = false;
+		}
+		cout << n * 8 << " bytes " << (allocator.uses_pages(n) ? "mapped" : "from the heap")
+			<< ", address modulo 64: " << (uintptr_t)values % 64 << endl;
+		if((uintptr_t)values % 64 != 0) test_success = false;
+		allocator.deallocate(values, n);
+	}
+	if(allocator.uses_pages(100) || !allocator.uses_pages((size_t)1 << 20)) test_success = false;
+
+	if(!fits_cache_lines<hashtable_oa<int>::Entry>() || !fits_cache_lines<hashtable_oa<double>::Entry>() ||
+		!fits_cache_lines<hashtable_oa<string>::Entry>()) test_success = false;
+	cout << "entry sizes: int " << sizeof(hashtable_oa<int>::Entry) << ", double " << sizeof(hashtable_oa<double>::Entry)
+		<< ", string " << sizeof(hashtable_oa<string>::Entry) << endl;
+
+	//grows through the page mapped sizes
+	hashtable_oa<int> ht(10);
+	for(int i = 0; i < 500000; i++)
+		ht.insert(i);
+	for(int i = 0; i < 500000; i++){
+		if(!ht.contains(i)) test_success = false;
+	}
+	cout << "table with " << ht.capacity() << " slots\n" << endl;
+
+	if(test_success)
+		cout << "SUCCESS\n" << endl;
+	else
+		cout << "FAILED\n" << endl;
+}
+// TRACE UNIT TESTS =====================================================================================
+
+void test_trace_raw_keys(){
+	cout << "====  Test case: record a trace with raw keys and replay it ====\n" << endl;
+	const string path = "test_trace_raw.bin";
+	vector<trace_record> expected;
+	bool calls_success = true;
+	recorded_table<hashtable_sc<int>> ht(10);
+	{
+		trace_writer<int> writer(path, trace_raw_keys);
+		ht.insert(-7);
+		ht.record_to(&writer);
+		for(int i = -50; i < 50; i++){
+			ht.insert(i * 1000);
+			expected.push_back({ trace_insert, (uint64_t)(int64_t)(i * 1000) });
+		}
+		ht.rehash(512);
+		expected.push_back({ trace_rehash, 512 });
+		for(int i = -50; i < 50; i += 3){
+			ht.erase(i * 1000);
+			expected.push_back({ trace_erase, (uint64_t)(int64_t)(i * 1000) });
+			bool found = ht.contains(i * 1000 + 1000);
+			expected.push_back({ trace_contains, (uint64_t)(int64_t)(i * 1000 + 1000) });
+			if(found != (i + 1 < 50 && (i + 1 + 50) % 3 != 0)) calls_success = false;
+		}
+		ht.record_to(nullptr);
+		ht.insert(123456);
+		if(writer.size() != expected.size() || !writer.ok()) calls_success = false;
+	}
+
+	trace t;
+	bool test_success = calls_success && read_trace(path, t) && t.keys == trace_raw_keys && t.records.size() == expected.size();
+	for(size_t i = 0; test_success && i < expected.size(); i++){
+		if(t.records[i].kind != expected[i].kind || t.records[i].key != expected[i].key) test_success = false;
+	}
+	cout << "read " << t.records.size() << " of " << expected.size() << " records" << endl;
+
+	//the replay holds the recorded values except the ones inserted while not recording
+	hashtable_oa<int> replayed(10);
+	for(const trace_record& record : t.records){
+		if(record.kind == trace_insert) replayed.insert((int)record.key);
+		else if(record.kind == trace_erase) replayed.erase((int)record.key);
+		else if(record.kind == trace_rehash) replayed.rehash(record.key);
+	}
+	cout << "replayed table holds " << replayed.size() << " values, recorded one " << ht.size() << "\n" << endl;
+	if(replayed.size() + 2 != ht.size() || replayed.contains(-7) || replayed.contains(123456)) test_success = false;
+	for(int value : replayed){
+		if(!ht.table().contains(value)) test_success = false;
+	}
+
+	//truncated and foreign files are rejected
+	trace broken;
+	{
+		ofstream out(path, ios::binary | ios::trunc);
+		out << "not a trace";
+	}
+	if(read_trace(path, broken) || read_trace("missing_trace.bin", broken)) test_success = false;
+	remove(path.c_str());
+
+	if(test_success)
+		cout << "SUCCESS\n" << endl;
+	else
+		cout << "FAILED\n" << endl;
+}
+
+void test_trace_hashed_keys(){
+	cout << "====  Test case: record a trace of strings with hashed keys ====\n" << endl;
+	const string path = "test_trace_hashed.bin";
+	recorded_table<hashtable_sc<string>> ht(10);
+	{
+		//raw keys are not possible for strings, the writer falls back to hashing
+		trace_writer<string> writer(path, trace_raw_keys);
+		ht.record_to(&writer);
+		for(int round = 0; round < 2; round++){
+			for(int i = 0; i < 1000; i++)
+				ht.insert("key " + to_string(i));
+		}
+		ht.contains("key 999");
+	}
+
+	trace t;
+	bool test_success = read_trace(path, t) && t.keys == trace_hashed_keys && t.records.size() == 2001;
+	remove(path.c_str());
+
+	//the second round repeats the keys of the first, all keys of one round differ
+	unordered_set<uint64_t> keys;
+	for(size_t i = 0; test_success && i < 1000; i++){
+		if(t.records[i].key != t.records[i + 1000].key) test_success = false;
+		keys.insert(t.records[i].key);
+	}
+	cout << keys.size() << " distinct hashed keys\n" << endl;
+	if(keys.size() != 1000 || t.records[2000].kind != trace_contains || t.records[2000].key != t.records[999].key)
+		test_success = false;
+
+	if(test_success)
+		cout << "SUCCESS\n" << endl;
+	else
+		cout << "FAILED\n" << endl;
+}
+// PERSISTENT SET UNIT TESTS ============================================================================
+
+//values of the set, by iteration, have to be exactly the ones of reference
+template<typename T>
+bool same_values(const T& ht, const unordered_set<int>& reference){
+	size_t iterated = 0;
+	for(int value : ht){
+		if(!reference.count(value)) return false;
+		iterated++;
+	}
+	if(iterated != reference.size() || ht.size() != reference.size()) return false;
+	for(int value : reference){
+		if(!ht.contains(value)) return false;
+	}
+	return true;
+}
+
+void test_versions_persistent(){
+	cout << "====  Test case: persistent set versions share their unchanged nodes ====\n" << endl;
+	bool test_success = true;
+
+	//every version keeps its values while later versions are derived from it
+	vector<hashtable_persistent<int>> versions(1);
+	for(int i = 0; i < 2000; i++)
+		versions.push_back(versions.back().insert(i * 7));
+	hashtable_persistent<int> erased = versions.back();
+	for(int i = 0; i < 2000; i += 2)
+		erased = erased.erase(i * 7);
+	for(size_t v = 0; v < versions.size(); v += 250){
+		unordered_set<int> reference;
+		for(size_t i = 0; i < v; i++)
+			reference.insert((int)i * 7);
+		if(!same_values(versions[v], reference)) test_success = false;
+	}
+	unordered_set<int> odd;
+	for(int i = 1; i < 2000; i += 2)
+		odd.insert(i * 7);
+	if(!same_values(erased, odd) || versions.back().size() != 2000) test_success = false;
+	cout << versions.size() << " versions, the last one with " << versions.back().size()
+		<< " values, after erasing every second value " << erased.size() << endl;
+
+	//inserting a stored value or erasing a missing one returns an equal version
+	if(versions.back().insert(7) != versions.back() || erased.erase(0) != erased) test_success = false;
+	if(erased == versions.back() || !(versions[3].erase(14).insert(14) == versions[3])) test_success = false;
+
+	//colliding hashes end in collision nodes below the last hash bits
+	hashtable_persistent<int, custom_hash<int>> colliding;
+	for(int i = 0; i < 50; i++)
+		colliding = colliding.insert(i);
+	hashtable_persistent<int, custom_hash<int>> halved = colliding;
+	for(int i = 0; i < 50; i += 2)
+		halved = halved.erase(i);
+	for(int i = 0; i < 50; i++){
+		if(!colliding.contains(i) || halved.contains(i) != (i % 2 == 1)) test_success = false;
+	}
+	cout << "colliding values: " << colliding.size() << ", after erasing the even ones " << halved.size() << "\n" << endl;
+	if(colliding.size() != 50 || halved.size() != 25) test_success = false;
+
+	if(test_success)
+		cout << "SUCCESS\n" << endl;
+	else
+		cout << "FAILED\n" << endl;
+}
+
+void test_builder_persistent(){
+	cout << "====  Test case: bulk edits with the transient builder ====\n" << endl;
+	bool test_success = true;
+	unordered_set<int> reference;
+	hashtable_persistent<int>::builder builder = hashtable_persistent<int>().transient();
+	for(int i = 0; i < 100000; i++){
+		builder.insert(i);
+		reference.insert(i);
+	}
+	hashtable_persistent<int> snapshot = builder.persistent();
+
+	//changes after persistent() do not reach the snapshot
+	unordered_set<int> changed = reference;
+	for(int i = 0; i < 100000; i += 3){
+		builder.erase(i);
+		changed.erase(i);
+	}
+	for(int i = 100000; i < 110000; i++){
+		builder.insert(i);
+		changed.insert(i);
+	}
+	hashtable_persistent<int> later = builder.persistent();
+	cout << "snapshot with " << snapshot.size() << " values, builder continued to " << later.size() << endl;
+	if(!same_values(snapshot, reference) || !same_values(later, changed)) test_success = false;
+
+	//a builder of a version copies the shared nodes and leaves the version alone
+	hashtable_persistent<int>::builder other = snapshot.transient();
+	for(int i = 0; i < 100000; i++)
+		other.erase(i);
+	cout << "builder emptied a copy of the snapshot: " << other.size() << " values, snapshot " << snapshot.size() << "\n" << endl;
+	if(!other.empty() || other.persistent().begin() != other.persistent().end() || !same_values(snapshot, reference))
+		test_success = false;
+	if(snapshot != snapshot.transient().persistent()) test_success = false;
+
+	if(test_success)
+		cout << "SUCCESS\n" << endl;
+	else
+		cout << "FAILED\n" << endl;
+}
+// ADAPTIVE TABLE UNIT TESTS ============================================================================
+
+//value with a key and 252 bytes of payload, compared and hashed by all bytes
+struct large_value {
+	int key;
+	int payload[63];
+
+	large_value(int key = 0) : key(key) {
+		for(int i = 0; i < 63; i++)
+			payload[i] = key + i;
+	}
+
+	bool operator==(const large_value& other) const {
+		return memcmp(this, &other, sizeof(large_value)) == 0;
+	}
+};
+
+void test_read_heavy_adaptive(){
+	cout << "====  Test case: a read heavy set of small keys moves to open addressing ====\n" << endl;
+	cout << "inserting 20000 integers into a chaining table with 8 lookups per insert..." << endl;
+	hashtable_adaptive<int> ht(16, chaining_layout);
+	unordered_set<int> reference;
+	for(int i = 0; i < 20000; i++){
+		ht.insert(i * 7);
+		reference.insert(i * 7);
+		for(int j = 0; j < 8; j++)
+			ht.contains(i * 7 - j);
+		if(i % 10 == 0){
+			ht.erase(i * 7 - 70);
+			reference.erase(i * 7 - 70);
+		}
+	}
+	cout << "layout " << (ht.layout() == open_addressing_layout ? "open addressing" : "chaining") << ", "
+		<< ht.migrations() << " migration(s), " << ht.size() << " values\n" << endl;
+	bool test_success = ht.layout() == open_addressing_layout && ht.migrations() == 1 && same_values(ht, reference);
+
+	//the layout survives clear, rehash keeps the values
+	ht.rehash(100000);
+	if(ht.capacity() != 100000 || !same_values(ht, reference)) test_success = false;
+	ht.clear();
+	if(!ht.empty() || ht.begin() != ht.end() || ht.contains(7)) test_success = false;
+
+	if(test_success)
+		cout << "SUCCESS\n" << endl;
+	else
+		cout << "FAILED\n" << endl;
+}
+
+void test_erase_heavy_adaptive(){
+	cout << "====  Test case: an erase heavy set of large values moves to chaining ====\n" << endl;
+	cout << "inserting 2 and erasing 1 value of 256 bytes per step in an open addressing table..." << endl;
+	hashtable_adaptive<large_value> ht(16);
+	for(int i = 0; i < 10000; i++){
+		ht.insert(large_value(2 * i));
+		ht.insert(large_value(2 * i + 1));
+		ht.erase(large_value(i));
+		ht.contains(large_value(i + 1));
+	}
+	cout << "layout " << (ht.layout() == chaining_layout ? "chaining" : "open addressing") << ", estimated cache lines per operation: chaining "
+		<< ht.estimated_cost(chaining_layout, ht.capacity()) << ", open addressing " << ht.estimated_cost(open_addressing_layout, ht.capacity()) << endl;
+	cout << ht.size() << " values\n" << endl;
+
+	bool test_success = ht.layout() == chaining_layout && ht.migrations() == 1 && ht.size() == 10000;
+	for(int i = 0; i < 20000; i++){
+		if(ht.contains(large_value(i)) != (i >= 10000)) test_success = false;
+	}
+	size_t iterated = 0;
+	for(const large_value& value : ht){
+		if(value.key < 10000 || !(value == large_value(value.key))) test_success = false;
+		iterated++;
+	}
+	if(iterated != 10000) test_success = false;
+
+	if(test_success)
+		cout << "SUCCESS\n" << endl;
+	else
+		cout << "FAILED\n" << endl;
+}
+
+// PARTITIONED AGGREGATION UNIT TESTS ===================================================================
+
+void test_partitioned_aggregation(execution_policy policy){
+	cout << "====  Test case: thread local partitioned sets merged with " << policy.threads << " thread(s) ====\n" << endl;
+	//every worker sees an overlapping range of keys, as in a distributed count distinct
+	vector<partitioned_set<int>> locals(4, partitioned_set<int>(4));
+	parallel_for(par(4), 4, [&](size_t, size_t first, size_t last){
+		for(size_t t = first; t < last; t++){
+			for(int i = 0; i < 50000; i++)
+				locals[t].insert((int)t * 10000 + i);
+		}
+	});
+	//a local with another partition count takes the slow path
+	locals.push_back(partitioned_set<int>(2));
+	for(int i = -100; i < 100; i++)
+		locals.back().insert(i);
+
+	partitioned_set<int> merged = partitioned_set<int>::merge(locals, policy);
+	size_t expected = 30000 + 50000 + 100;
+	cout << "merged " << merged.size() << " distinct values, expected " << expected << ", in "
+		<< merged.partition_count() << " partitions" << endl;
+
+	bool test_success = merged.size() == expected && merged.partition_count() == 16;
+	for(int i = -100; i < 80000; i++){
+		if(!merged.contains(i)) test_success = false;
+	}
+	if(merged.contains(80000) || merged.contains(-101)) test_success = false;
+	for(size_t i = 0; i < merged.partition_count(); i++){
+		for(int value : merged.partition(i)){
+			if(merged.partition_of(value) != i) test_success = false;
+		}
+	}
+	size_t left = 0;
+	for(const partitioned_set<int>& local : locals)
+		left += local.size();
+	cout << left << " values left in the locals\n" << endl;
+	if(left != 0) test_success = false;
+
+	atomic<size_t> visited(0);
+	merged.for_each(policy, [&](int){ visited++; });
+	if(visited != expected) test_success = false;
+
+	if(test_success)
+		cout << "SUCCESS\n" << endl;
+	else
+		cout << "FAILED\n" << endl;
+}
+// WORKLOAD UNIT TESTS ==================================================================================
+
+void test_key_distributions(){
+	cout << "====  Test case: key distributions of the workload generator ====\n" << endl;
+	cout << "drawing 200000 keys from a key space of 1000 with every distribution..." << endl;
+	workload_config config;
+	config.key_space = 1000;
+	config.threads = 2;
+	bool test_success = true;
+	vector<size_t> counts[4];
+	for(int d = uniform_keys; d <= sequential_keys; d++){
+		config.distribution = (key_distribution)d;
+		key_generator keys(config, 0);
+		counts[d].assign(1000, 0);
+		for(int i = 0; i < 200000; i++){
+			uint64_t key = keys.next();
+			if(key >= 1000) test_success = false;
+			else counts[d][key]++;
+		}
+	}
+
+	for(size_t count : counts[uniform_keys]){
+		if(count < 140 || count > 260) test_success = false;
+	}
+	//zipfian: rank 0 gets 1 / zeta(1000, 0.99) of the draws, about 13%
+	double top = counts[zipfian_keys][0] / 200000.0;
+	double expected_top = 1 / key_generator::zeta(1000, 0.99);
+	cout << "zipfian: key 0 drawn " << top * 100 << "%, expected " << expected_top * 100 << "%" << endl;
+	if(fabs(top - expected_top) > 0.01 || counts[zipfian_keys][1] >= counts[zipfian_keys][0] ||
+		counts[zipfian_keys][100] >= counts[zipfian_keys][10]) test_success = false;
+	size_t hot = 0;
+	for(int key = 0; key < 200; key++)
+		hot += counts[hotspot_keys][key];
+	cout << "hotspot: " << hot / 2000.0 << "% of the draws in the hot 20% of the keys" << endl;
+	if(fabs(hot / 200000.0 - 0.8) > 0.01) test_success = false;
+	for(size_t count : counts[sequential_keys]){
+		if(count != 200) test_success = false;
+	}
+	//the second thread starts in the middle of the key space
+	key_generator second(config, 1);
+	if(second.next() != 500 || second.next() != 501) test_success = false;
+	cout << endl;
+
+	if(test_success)
+		cout << "SUCCESS\n" << endl;
+	else
+		cout << "FAILED\n" << endl;
+}
+
+template<typename Table>
+void test_workload(const string& description){
+	cout << "====  Test case: 4 threads on a locked " << description << " ====\n" << endl;
+	cout << "running 20000 zipfian operations per thread, 50% reads, 25% inserts, 25% erases..." << endl;
+	workload_config config;
+	config.threads = 4;
+	config.key_space = 1000;
+	config.distribution = zipfian_keys;
+	config.reads = 0.5;
+	config.inserts = 0.25;
+	config.erases = 0.25;
+	config.operations = 20000;
+	Table ht(16);
+	locked_table<Table> locked(ht);
+	workload_result result = run_workload(locked, config);
+	cout << result.operations_per_second() << " ops/s, p50 " << result.latencies.percentile_ns(0.5) << " ns, p99 "
+		<< result.latencies.percentile_ns(0.99) << " ns, " << result.hits << " hits, " << ht.size() << " keys left\n" << endl;
+
+	bool test_success = result.threads == 4 && result.operations == 80000 && result.latencies.count() == 80000 &&
+		result.hits > 0 && result.hits < 40000 && ht.size() <= 1000;
+	for(uint64_t key : ht){
+		if(key >= 1000) test_success = false;
+	}
+
+	if(test_success)
+		cout << "SUCCESS\n" << endl;
+	else
+		cout << "FAILED\n" << endl;
+}
+
+// BULK LOADING UNIT TESTS ==============================================================================
+
+void test_bulk_load_lines(execution_policy policy){
+	cout << "====  Test case: loading a text file with " << policy.threads << " thread(s) ====\n" << endl;
+	cout << "writing 20000 lines with duplicates, empty lines and \\r\\n, loading them in 4 KB windows..." << endl;
+	string path = "bulk_load_test.txt";
+	unordered_set<string> reference;
+	{
+		ofstream out(path, ios::binary | ios::trunc);
+		for(int i = 0; i < 20000; i++){
+			string key = "key" + to_string(i % 15000) + string(i % 7, 'x');
+			reference.insert(key);
+			out << key << (i % 3 == 0 ? "\r\n" : "\n");
+			if(i % 1000 == 0) out << "\n";
+		}
+		out << "last line without line end";
+		reference.insert("last line without line end");
+	}
+
+	partitioned_set<string> strings(3);
+	bool test_success = load_lines(path, strings, policy, 4096);
+	cout << "loaded " << strings.size() << " distinct strings, expected " << reference.size() << endl;
+	if(strings.size() != reference.size()) test_success = false;
+	for(const string& key : reference){
+		if(!strings.contains(key)) test_success = false;
+	}
+
+	//the same path fills chained partitions
+	partitioned_set<string, default_hash<string>, equal_to<string>, hashtable_sc<string>> chains(2);
+	if(!load_lines(path, chains, policy) || chains.size() != reference.size()) test_success = false;
+
+	{
+		ofstream out(path, ios::binary | ios::trunc);
+		for(int i = -5000; i < 5000; i++)
+			out << i * 3 << "\n";
+		out << "12x\n";
+	}
+	partitioned_set<int> numbers(2);
+	//the bad line is reported, the others are loaded anyway
+	if(load_lines(path, numbers, policy, 1000) || numbers.size() != 10000 || !numbers.contains(-15000) ||
+		!numbers.contains(14997) || numbers.contains(1) || numbers.contains(15000)) test_success = false;
+	remove(path.c_str());
+	if(load_lines("missing_keys.txt", numbers, policy)) test_success = false;
+	cout << "loaded " << numbers.size() << " integers\n" << endl;
+
+	if(test_success)
+		cout << "SUCCESS\n" << endl;
+	else
+		cout << "FAILED\n" << endl;
+}
+
+void test_bulk_load_binary(execution_policy policy){
+	cout << "====  Test case: loading a binary file with " << policy.threads << " thread(s) ====\n" << endl;
+	cout << "writing 100000 64 bit keys, loading them in windows of 10000 bytes..." << endl;
+	string path = "bulk_load_test.bin";
+	{
+		ofstream out(path, ios::binary | ios::trunc);
+		for(uint64_t i = 0; i < 100000; i++){
+			uint64_t key = i * 0x9e3779b97f4a7c15ULL;
+			out.write((const char*)&key, sizeof(key));
+		}
+	}
+	partitioned_set<uint64_t> keys(4);
+	//presizing keeps the settings of the partitions
+	keys.partition(0).reseed();
+	bool test_success = load_binary(path, keys, policy, 10000);
+	cout << "loaded " << keys.size() << " keys\n" << endl;
+	if(keys.size() != 100000) test_success = false;
+	if(keys.partition(0).hash_mode() != flood_guard<uint64_t, default_hash<uint64_t>, equal_to<uint64_t>>::seeded) test_success = false;
+	for(uint64_t i = 0; i < 100000; i++){
+		if(!keys.contains(i * 0x9e3779b97f4a7c15ULL)) test_success = false;
+	}
+
+	//a partial record at the end is reported
+	{
+		ofstream out(path, ios::binary | ios::app);
+		out << "abc";
+	}
+	partitioned_set<uint64_t> partial(4);
+	if(load_binary(path, partial, policy) || partial.size() != 100000) test_success = false;
+	remove(path.c_str());
+
+	if(test_success)
+		cout << "SUCCESS\n" << endl;
+	else
+		cout << "FAILED\n" << endl;
+}
+// INSTRUMENTATION UNIT TESTS ===========================================================================
+
+void test_latency_histogram(){
+	cout << "====  Test case: HDR latency histogram ====\n" << endl;
+	bool test_success = true;
+
+	//every value lies in its bucket and the middle of the bucket is within 1/16 of it
+	for(uint64_t value = 1; value < ((uint64_t)1 << 62); value = value * 3 / 2 + 1){
+		size_t bucket = latency_histogram::bucket_of(value);
+		uint64_t middle = latency_histogram::middle_of(bucket);
+		if(bucket >= latency_histogram::BUCKETS || (double)(middle > value ? middle - value : value - middle) > value / 16.0)
+			test_success = false;
+		if(bucket > 0 && latency_histogram::bucket_of(value - 1) > bucket) test_success = false;
+	}
+
+	//4 threads record 1..100000 ticks each
+	latency_histogram histogram;
+	parallel_for(par(4), 4, [&](size_t, size_t first, size_t last){
+		for(size_t t = first; t < last; t++){
+			for(uint64_t ticks = 1; ticks <= 100000; ticks++)
+				histogram.record(ticks);
+		}
+	});
+	double ns_per_tick = tsc_ns_per_tick();
+	double p50 = histogram.percentile_ns(0.5) / ns_per_tick;
+	double p999 = histogram.percentile_ns(0.999) / ns_per_tick;
+	cout << histogram.count() << " values, p50 " << p50 << " ticks, p99.9 " << p999 << " ticks, max "
+		<< histogram.max_ns() / ns_per_tick << " ticks, " << ns_per_tick << " ns per tick\n" << endl;
+	if(histogram.count() != 400000 || fabs(p50 - 50000) > 50000 / 16.0 || fabs(p999 - 99900) > 99900 / 16.0 ||
+		fabs(histogram.max_ns() / ns_per_tick - 100000) > 1) test_success = false;
+	latency_histogram copy(histogram);
+	histogram.reset();
+	if(histogram.count() != 0 || copy.count() != 400000 || histogram.percentile_ns(0.5) != 0) test_success = false;
+
+	if(test_success)
+		cout << "SUCCESS\n" << endl;
+	else
+		cout << "FAILED\n" << endl;
+}
+
+#ifdef HASHTABLE_INSTRUMENTATION
+//the rehash events of a growing table arrive in start/end pairs with growing capacities
+template<typename T>
+void test_instrumented_table(const string& description){
+	cout << "====  Test case: latency and rehash events, " << description << " ====\n" << endl;
+	T ht(10);
+	vector<rehash_event> starts, ends;
+	ht.stats().on_rehash_start = [&](const rehash_event& e){ starts.push_back(e); };
+	ht.stats().on_rehash_end = [&](const rehash_event& e){ ends.push_back(e); };
+	for(int i = 0; i < 10000; i++)
+		ht.insert(i);
+	for(int i = 0; i < 20000; i++)
+		ht.contains(i);
+	for(int i = 0; i < 10000; i += 2)
+		ht.erase(i);
+
+	bool test_success = !starts.empty() && starts.size() == ends.size() && ht.stats().rehashes.count() == ends.size();
+	double longest = 0;
+	for(size_t i = 0; test_success && i < ends.size(); i++){
+		if(starts[i].old_capacity != ends[i].old_capacity || starts[i].new_capacity <= starts[i].old_capacity ||
+			starts[i].pause_ns != 0 || ends[i].pause_ns <= 0 || starts[i].size != ends[i].size) test_success = false;
+		if(i > 0 && starts[i].old_capacity != starts[i - 1].new_capacity) test_success = false;
+		longest = max(longest, ends[i].pause_ns);
+	}
+	table_stats& stats = ht.stats();
+	cout << ends.size() << " rehashes, longest pause " << longest << " ns" << endl;
+	cout << stats.inserts.count() << " inserts, p50 " << stats.inserts.percentile_ns(0.5) << " ns, p99.9 "
+		<< stats.inserts.percentile_ns(0.999) << " ns, max " << stats.inserts.max_ns() << " ns" << endl;
+	cout << stats.lookups.count() << " lookups, p50 " << stats.lookups.percentile_ns(0.5) << " ns\n" << endl;
+	//the slowest insert is the one that waited for the largest rehash
+	if(stats.inserts.count() != 10000 || stats.lookups.count() != 20000 || stats.erases.count() != 5000 ||
+		stats.inserts.max_ns() < longest) test_success = false;
+
+	if(test_success)
+		cout << "SUCCESS\n" << endl;
+	else
+		cout << "FAILED\n" << endl;
+}
+#endif
+
+
+
+// APPROXIMATE MEMBERSHIP UNIT TESTS =====================================================================
+
+void test_cuckoo_filter(double fp_rate){
+	cout << "====  Test case: cuckoo filter with a target false positive rate of " << fp_rate << " ====\n" << endl;
+	cout << "inserting 100000 keys, querying 1000000 other keys, erasing every second key..." << endl;
+	cuckoo_filter<int> filter(100000, fp_rate);
+	bool test_success = true;
+	for(int i = 0; i < 100000; i++){
+		if(!filter.insert(i)) test_success = false;
+	}
+	for(int i = 0; i < 100000; i++){
+		if(!filter.contains(i)) test_success = false; //no false negatives
+	}
+	int false_positives = 0;
+	for(int i = 100000; i < 1100000; i++){
+		if(filter.contains(i)) false_positives++;
+	}
+	double rate = false_positives / 1000000.0;
+	cout << filter.fingerprint_bits() << " bit fingerprints, load factor " << filter.load_factor() << endl;
+	cout << "false positive rate: measured with keys " << rate << ", with random hashes " << filter.measured_false_positive_rate()
+		<< ", expected " << filter.expected_false_positive_rate() << endl;
+	cout << "bits per key: " << filter.bits_per_key() << endl;
+	if(filter.size() != 100000 || rate > 2 * fp_rate || filter.bits_per_key() > 1.5 * log2(1 / fp_rate) + 5) test_success = false;
+
+	for(int i = 0; i < 100000; i += 2){
+		if(!filter.erase(i)) test_success = false;
+	}
+	for(int i = 1; i < 100000; i += 2){
+		if(!filter.contains(i)) test_success = false;
+	}
+	int still_found = 0;
+	for(int i = 0; i < 100000; i += 2){
+		if(filter.contains(i)) still_found++;
+	}
+	cout << "erased keys still reported: " << still_found << "\n" << endl;
+	if(filter.size() != 50000 || still_found > 50000 * 2 * fp_rate) test_success = false;
+
+	if(test_success)
+		cout << "SUCCESS\n" << endl;
+	else
+		cout << "FAILED\n" << endl;
+}
+
+void test_cuckoo_filter_full(){
+	cout << "====  Test case: inserting into a full cuckoo filter ====\n" << endl;
+	cout << "inserting until an insert fails, then erasing and inserting again..." << endl;
+	cuckoo_filter<int> filter(1000, 0.01);
+	int inserted = 0;
+	while(inserted < 100000 && filter.insert(inserted))
+		inserted++;
+	cout << inserted << " keys in " << filter.capacity() << " slots, load factor " << filter.load_factor() << "\n" << endl;
+
+	bool test_success = inserted < 100000 && filter.load_factor() > 0.9;
+	for(int i = 0; i < inserted; i++){
+		if(!filter.contains(i)) test_success = false; //no key was lost while kicking
+	}
+	for(int i = 0; i < 100; i++){
+		if(!filter.erase(i)) test_success = false;
+	}
+	if(!filter.insert(-1) || !filter.contains(-1)) test_success = false;
+	filter.clear();
+	if(!filter.empty() || filter.contains(-1) || !filter.insert(1)) test_success = false;
+
+	if(test_success)
+		cout << "SUCCESS\n" << endl;
+	else
+		cout << "FAILED\n" << endl;
+}
+
+
+
+int main() {		
+
+	print_header("SEPARATE CHAINING");
+	{
+		shared_ptr<hashtable_sc<int>> ht = make_shared<hashtable_sc<int>>(10);
+		test_queries_sc(ht, 10, 5);
+	}
+	{
+		shared_ptr<hashtable_sc<int>> ht = make_shared<hashtable_sc<int>>(10);
+		test_insert_sc(ht, 5);
+	}
+
+	{
+		shared_ptr<hashtable_sc<int>> ht = make_shared<hashtable_sc<int>>(10);
+		test_insert_duplicates_sc(ht, 42);
+	}
+	{
+		shared_ptr<hashtable_sc<int>> ht = make_shared<hashtable_sc<int>>(10);
+		int test_values[5] = { 1,2,3,4,5 };
+		test_clear_sc(ht, test_values);
+	}
+	{
+		shared_ptr<hashtable_sc<int>> ht = make_shared<hashtable_sc<int>>(10);
+		test_queries_sc(ht, 10, 4);
+	}
+	{
+		shared_ptr<hashtable_sc<int>> ht = make_shared<hashtable_sc<int>>(10);
+		test_erase_sc(ht, 5, 6, 7);
+	}
+	{
+		shared_ptr<hashtable_sc<int>> ht = make_shared<hashtable_sc<int>>(10);
+		test_erase_nonexistent_value_sc(ht, 1,2,3);
+	}
+	{
+		shared_ptr<hashtable_sc<int>> ht = make_shared<hashtable_sc<int>>(10);
+		int rehash_test_values[10] = { 0,1,2,3,4,5,6,7,8,9 };
+		test_rehash_sc(ht, rehash_test_values, 10);
+	}
+	{
+		shared_ptr<hashtable_sc<int>> ht = make_shared<hashtable_sc<int>>(10);
+		int test_values[5] = { 1,2,3,4,5 };
+		test_iterator_sc(ht, test_values, 5);
+	}
+	{
+		shared_ptr<hashtable_sc<int>> ht = make_shared<hashtable_sc<int>>(10);
+		shared_ptr<hashtable_sc<int>> ht2 = make_shared<hashtable_sc<int>>(10);
+		int test_values[5] = { 1,2,3,4,5 };
+		test_equal_operator_sc(ht, ht2, test_values, 5);
+	}
+	test_custom_hash_functor_sc();
+	test_custom_comp_functor_sc();
+	test_equal_operator_order_independent_sc();
+	test_set_algebra_sc(20, seq);
+	test_set_algebra_sc(10, seq);
+	test_set_algebra_sc(10, par(4));
+	test_bloom_filter_sc();
+	test_flood_defense_sc();
+	test_move_semantics_sc();
+	test_node_handle_sc();
+	test_erase_if_sc(seq);
+	test_erase_if_sc(par(4));
+	test_treeify_sc();
+	test_partitions<hashtable_sc<int>>("separate chaining");
+
+
+
+	//----------------------------------------------------------------------
+
+	print_header("OPEN ADDRESSING");
+	{
+		shared_ptr<hashtable_oa<int>> ht = make_shared<hashtable_oa<int>>(10);
+		test_queries_oa(ht, 10, 5);
+	}
+	{
+		shared_ptr<hashtable_oa<int>> ht = make_shared<hashtable_oa<int>>(10);
+		test_insert_oa(ht, 5);
+	}
+
+	{
+		shared_ptr<hashtable_oa<int>> ht = make_shared<hashtable_oa<int>>(10);
+		test_insert_duplicates_oa(ht, 42);
+	}
+	{
+		shared_ptr<hashtable_oa<int>> ht = make_shared<hashtable_oa<int>>(10);
+		int test_values[5] = { 1,2,3,4,5 };
+		test_clear_oa(ht, test_values);
+	}
+	{
+		shared_ptr<hashtable_oa<int>> ht = make_shared<hashtable_oa<int>>(10);
+		test_erase_oa(ht, 5, 6, 7);
+	}
+	{
+		shared_ptr<hashtable_oa<int>> ht = make_shared<hashtable_oa<int>>(10);
+		test_erase_nonexistent_value_oa(ht, 1, 2, 3);
+	}
+	{
+		shared_ptr<hashtable_oa<int>> ht = make_shared<hashtable_oa<int>>(10);
+		int rehash_test_values[10] = { 0,1,2,3,4,5,6,7,8,9 };
+		test_rehash_oa(ht, rehash_test_values, 10);
+	}
+	
+	{
+		shared_ptr<hashtable_oa<int>> ht = make_shared<hashtable_oa<int>>(10);
+		int test_values[5] = { 1,2,3,4,5 };
+		test_iterator_oa(ht, test_values, 5);
+	}
+	{
+		shared_ptr<hashtable_oa<int>> ht = make_shared<hashtable_oa<int>>(10);
+		shared_ptr<hashtable_oa<int>> ht2 = make_shared<hashtable_oa<int>>(10);
+		int test_values[5] = { 1,2,3,4,5 };
+		test_equal_operator_oa(ht, ht2, test_values, 5);
+	}
+	test_custom_hash_functor_oa();
+	test_custom_comp_functor_oa();
+	test_skip_deleted_value_oa();
+	test_equal_operator_order_independent_oa();
+	test_set_algebra_oa(20, seq);
+	test_set_algebra_oa(20, par(4));
+	test_bloom_filter_oa();
+	test_flood_defense_oa();
+	test_move_semantics_oa();
+	test_erase_if_oa(seq);
+	test_erase_if_oa(par(4));
+	test_erase_if_oa(par(8));
+	test_cache_oa();
+	test_partitions<hashtable_oa<int>>("open addressing");
+
+	//----------------------------------------------------------------------
+
+	print_header("CUCKOO HASHING");
+	test_insert_erase_cuckoo();
+	test_high_load_cuckoo();
+	test_collision_handling_cuckoo();
+	test_iterator_cuckoo();
+
+	//----------------------------------------------------------------------
+
+	print_header("HOPSCOTCH HASHING");
+	test_insert_erase_hopscotch();
+	test_high_load_hopscotch();
+	test_collision_handling_hopscotch();
+
+	//----------------------------------------------------------------------
+
+	print_header("SMALL SIZE");
+	test_inline_storage_small();
+	test_switch_to_table_small();
+
+	//----------------------------------------------------------------------
+
+	print_header("ADAPTIVE TABLE");
+	test_read_heavy_adaptive();
+	test_erase_heavy_adaptive();
+
+	//----------------------------------------------------------------------
+
+	print_header("STRING SET");
+	test_heterogeneous_lookup_string();
+	test_arena_compaction_string();
+
+	//----------------------------------------------------------------------
+
+	print_header("INTEGRAL KEYS");
+	{
+		hashtable_oa_int<int> ht(10);
+		test_random_operations_int(ht, "tombstones");
+	}
+	{
+		hashtable_oa_int<int, -1, -1> ht(10);
+		test_random_operations_int(ht, "backward shift deletion");
+	}
+	test_sentinels_int();
+
+	//----------------------------------------------------------------------
+
+	print_header("HASHING");
+	test_avalanche_hash();
+	test_distribution_hash();
+	test_hash_bytes_lengths();
+	test_siphash_reference();
+
+	//----------------------------------------------------------------------
+
+	print_header("STORAGE");
+	test_page_storage();
+	test_control_scans();
+
+	//----------------------------------------------------------------------
+
+	print_header("PERSISTENT SET");
+	test_versions_persistent();
+	test_builder_persistent();
+
+	//----------------------------------------------------------------------
+
+	print_header("PARTITIONED AGGREGATION");
+	test_partitioned_aggregation(seq);
+	test_partitioned_aggregation(par(4));
+
+	//----------------------------------------------------------------------
+
+	print_header("BULK LOADING");
+	test_bulk_load_lines(seq);
+	test_bulk_load_lines(par(4));
+	test_bulk_load_binary(seq);
+	test_bulk_load_binary(par(4));
+
+	//----------------------------------------------------------------------
+
+	print_header("WORKLOAD");
+	test_key_distributions();
+	test_workload<hashtable_sc<uint64_t>>("separate chaining");
+	test_workload<hashtable_oa<uint64_t>>("open addressing");
+
+	//----------------------------------------------------------------------
+
+	print_header("INSTRUMENTATION");
+	test_latency_histogram();
+#ifdef HASHTABLE_INSTRUMENTATION
+	test_instrumented_table<hashtable_sc<int>>("separate chaining");
+	test_instrumented_table<hashtable_oa<int>>("open addressing");
+#endif
+
+	//----------------------------------------------------------------------
+
+	print_header("TRACE");
+	test_trace_raw_keys();
+	test_trace_hashed_keys();
+
+	//----------------------------------------------------------------------
+
+	print_header("APPROXIMATE MEMBERSHIP");
+	test_cuckoo_filter(0.01);
+	test_cuckoo_filter(0.0001);
+	test_cuckoo_filter_full();
+
+	//----------------------------------------------------------------------
+
+	print_header("BLOOM FILTER");
+	test_blocked_bloom_filter();
 
 	shared_ptr<hashtable_sc<int>> ht = make_shared<hashtable_sc<int>>(10);
 	
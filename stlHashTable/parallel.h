@@ -0,0 +1,47 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+//number of worker threads an operation may use.
+//seq runs on the calling thread, par(n) splits the work into n chunks (0 -> one per core)
+struct execution_policy {
+	unsigned threads;
+};
+
+const execution_policy seq{ 1 };
+
+inline execution_policy par(unsigned threads = 0) {
+	if (threads == 0)
+		threads = std::thread::hardware_concurrency();
+	return execution_policy{ threads == 0 ? 1 : threads };
+}
+
+//upper bound for the chunk_index passed by parallel_for, used to size per-chunk results
+inline size_t chunk_count(execution_policy policy) {
+	return policy.threads == 0 ? 1 : policy.threads;
+}
+
+//splits [0, n) into contiguous chunks and calls fn(chunk_index, first, last) for each of them.
+//chunk 0 runs on the calling thread, the function returns when all chunks are done
+template<typename F>
+void parallel_for(execution_policy policy, size_t n, F fn) {
+	size_t chunks = std::min<size_t>(chunk_count(policy), std::max<size_t>(n, 1));
+	if (chunks == 1) {
+		fn(size_t(0), size_t(0), n);
+		return;
+	}
+
+	std::vector<std::thread> workers;
+	workers.reserve(chunks - 1);
+	for (size_t i = 1; i < chunks; i++) {
+		workers.emplace_back([&fn, i, n, chunks]() {
+			fn(i, n * i / chunks, n * (i + 1) / chunks);
+		});
+	}
+	fn(size_t(0), size_t(0), n / chunks);
+
+	for (std::thread& t : workers)
+		t.join();
+}
@@ -0,0 +1,184 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <ostream>
+#include <utility>
+#include <vector>
+#include "hash.h"
+#include "hashtable_oa.h"
+#include "parallel.h"
+
+
+
+//set split into 2^bits hashtable_oa partitions by the high bits of the hash, for parallel aggregation:
+//every worker thread fills its own partitioned_set without locks, then merge() combines partition i
+//of all workers into partition i of the result, all partitions concurrently. No value ever moves
+//to another partition, so the merge threads share nothing.
+//The partition tables index their slots with the low bits of the same hash, H has to spread
+//its values over the high bits too (default_hash does, std::hash<int> does not).
+//T is the partition table, hashtable_oa<V, H, C> or hashtable_sc<V, H, C>
+template<	typename V,
+					typename H = default_hash<V>,
+					typename C = std::equal_to<V>,
+					typename T = hashtable_oa<V, H, C>>
+class partitioned_set {
+
+	public:
+		typedef T table_type;
+
+		//capacity is the initial capacity of every partition
+		explicit partitioned_set(unsigned bits = 6, size_t capacity = 16);
+
+		void insert(const V& value);
+		void insert(V&& value);
+		void erase(const V& value);
+		bool contains(const V& value) const;
+		void clear();
+
+		size_t size() const;
+		bool empty() const;
+
+		size_t partition_count() const;
+		size_t partition_of(const V& value) const;
+		size_t partition_of_hash(size_t hash) const;
+		const table_type& partition(size_t i) const;
+		table_type& partition(size_t i);
+
+		//calls fn(value) for every value, with par(n) concurrently on whole partitions
+		template<typename F>
+		void for_each(execution_policy policy, F fn) const;
+
+		//moves the values of all locals into one set and leaves them empty. Partition i of the result
+		//starts as the largest partition i of the locals and takes the others with hashtable_oa::merge,
+		//with par(n) n partitions at a time. Locals with a different number of partitions are merged
+		//value by value afterwards
+		static partitioned_set merge(std::vector<partitioned_set>& locals, execution_policy policy = par());
+
+		friend std::ostream& operator<<(std::ostream& os, const partitioned_set<V, H, C, T>& ht) {
+			for (const table_type& part : ht.parts)
+				os << part;
+			return os;
+		}
+
+	private:
+		unsigned bits;
+		std::vector<table_type> parts;
+};
+
+//=========  PUBLIC FUNCITONS  =============
+
+template<	typename V, typename H, typename C, typename T>
+partitioned_set<V, H, C, T>::partitioned_set(unsigned bits, size_t capacity) {
+	this->bits = std::min(bits, 16u);
+	parts.reserve((size_t)1 << this->bits);
+	for (size_t i = 0; i < ((size_t)1 << this->bits); i++)
+		parts.push_back(table_type(capacity));
+}
+
+template<	typename V, typename H, typename C, typename T>
+void partitioned_set<V, H, C, T>::insert(const V& value) {
+	parts[partition_of(value)].insert(value);
+}
+
+template<	typename V, typename H, typename C, typename T>
+void partitioned_set<V, H, C, T>::insert(V&& value) {
+	size_t i = partition_of(value);
+	parts[i].insert(std::move(value));
+}
+
+template<	typename V, typename H, typename C, typename T>
+void partitioned_set<V, H, C, T>::erase(const V& value) {
+	parts[partition_of(value)].erase(value);
+}
+
+template<	typename V, typename H, typename C, typename T>
+bool partitioned_set<V, H, C, T>::contains(const V& value) const {
+	return parts[partition_of(value)].contains(value);
+}
+
+template<	typename V, typename H, typename C, typename T>
+void partitioned_set<V, H, C, T>::clear() {
+	for (table_type& part : parts)
+		part.clear();
+}
+
+template<typename V, typename H, typename C, typename T>
+size_t partitioned_set<V, H, C, T>::size() const {
+	size_t n = 0;
+	for (const table_type& part : parts)
+		n += part.size();
+	return n;
+}
+
+template<typename V, typename H, typename C, typename T>
+bool partitioned_set<V, H, C, T>::empty() const {
+	return size() == 0;
+}
+
+template<typename V, typename H, typename C, typename T>
+size_t partitioned_set<V, H, C, T>::partition_count() const {
+	return parts.size();
+}
+
+template<typename V, typename H, typename C, typename T>
+size_t partitioned_set<V, H, C, T>::partition_of(const V& value) const {
+	return partition_of_hash(H()(value));
+}
+
+//the partition of a value with H()(value) == hash
+template<typename V, typename H, typename C, typename T>
+size_t partitioned_set<V, H, C, T>::partition_of_hash(size_t hash) const {
+	return bits == 0 ? 0 : hash >> (sizeof(size_t) * 8 - bits);
+}
+
+template<typename V, typename H, typename C, typename T>
+const typename partitioned_set<V, H, C, T>::table_type& partitioned_set<V, H, C, T>::partition(size_t i) const {
+	return parts[i];
+}
+
+template<typename V, typename H, typename C, typename T>
+typename partitioned_set<V, H, C, T>::table_type& partitioned_set<V, H, C, T>::partition(size_t i) {
+	return parts[i];
+}
+
+template<typename V, typename H, typename C, typename T>
+template<typename F>
+void partitioned_set<V, H, C, T>::for_each(execution_policy policy, F fn) const {
+	parallel_for(policy, parts.size(), [&](size_t, size_t first, size_t last) {
+		for (size_t i = first; i < last; i++) {
+			for (const V& item : parts[i])
+				fn(item);
+		}
+	});
+}
+
+template<typename V, typename H, typename C, typename T>
+partitioned_set<V, H, C, T> partitioned_set<V, H, C, T>::merge(std::vector<partitioned_set>& locals, execution_policy policy) {
+	if (locals.empty())
+		return partitioned_set();
+	partitioned_set result(locals[0].bits);
+
+	parallel_for(policy, result.parts.size(), [&](size_t, size_t first, size_t last) {
+		for (size_t i = first; i < last; i++) {
+			//take over the largest partition, the others are moved into it
+			partitioned_set* largest = nullptr;
+			for (partitioned_set& local : locals) {
+				if (local.bits == result.bits && (largest == nullptr || local.parts[i].size() > largest->parts[i].size()))
+					largest = &local;
+			}
+			result.parts[i].swap(largest->parts[i]);
+			for (partitioned_set& local : locals) {
+				if (local.bits == result.bits)
+					result.parts[i].merge(std::move(local.parts[i]));
+			}
+		}
+	});
+
+	for (partitioned_set& local : locals) {
+		if (local.bits == result.bits) continue;
+		local.for_each(seq, [&](const V& value) { result.insert(value); });
+		local.clear();
+	}
+	return result;
+}
@@ -0,0 +1,254 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "flood_guard.h"
+#include "hash.h"
+
+//operation traces: recorded_table logs the calls to a table into a trace_writer, read_trace loads
+//the file again and the replay benchmark (stlHashTableBench replay) runs it against other tables.
+//
+//file layout: the 4 bytes "HTTR", a version byte, the key format byte and two reserved bytes,
+//followed by one record per call. A record is the operation byte and the key,
+//raw keys as a LEB128 varint of their zigzag value, hashed keys as 8 little endian bytes.
+//For trace_rehash the key is the requested capacity, always as varint
+
+enum trace_kind { trace_insert, trace_erase, trace_contains, trace_rehash };
+
+//raw keys store integers and enums as they are, hashed keys store a 64 bit keyed hash.
+//Hashed traces keep equal keys equal and different keys different (up to 64 bit collisions),
+//which is all a replay needs, without putting production keys into the file
+enum trace_keys { trace_raw_keys, trace_hashed_keys };
+
+struct trace_record {
+	trace_kind kind;
+	uint64_t key;
+};
+
+struct trace {
+	trace_keys keys;
+	std::vector<trace_record> records;
+};
+
+const char TRACE_MAGIC[4] = { 'H', 'T', 'T', 'R' };
+const unsigned char TRACE_VERSION = 1;
+
+//writes the trace of values of type V. Raw keys are only possible for integers and enums,
+//other types are hashed whatever keys says. Not thread safe, like the tables it records
+template<typename V>
+class trace_writer {
+
+	public:
+		static const bool raw_available = std::is_integral<V>::value || std::is_enum<V>::value;
+
+		trace_writer(const std::string& path, trace_keys keys = trace_hashed_keys)
+			: out(path, std::ios::binary | std::ios::trunc),
+			  keys(raw_available ? keys : trace_hashed_keys), k0(random_seed()), k1(random_seed()), count(0) {
+			buffer.insert(buffer.end(), TRACE_MAGIC, TRACE_MAGIC + 4);
+			buffer.push_back(TRACE_VERSION);
+			buffer.push_back((unsigned char)this->keys);
+			buffer.push_back(0);
+			buffer.push_back(0);
+		}
+
+		trace_writer(const trace_writer&) = delete;
+		trace_writer& operator=(const trace_writer&) = delete;
+
+		~trace_writer() {
+			flush();
+		}
+
+		//false when the file could not be opened or written
+		bool ok() const {
+			return out.good();
+		}
+
+		trace_keys key_format() const {
+			return keys;
+		}
+
+		//number of records written so far
+		size_t size() const {
+			return count;
+		}
+
+		void record(trace_kind kind, const V& value) {
+			buffer.push_back((unsigned char)kind);
+			if (keys == trace_raw_keys)
+				put_varint(zigzag(raw_key(value)));
+			else
+				put_fixed(hashed_key(value));
+			written();
+		}
+
+		void record_rehash(size_t capacity) {
+			buffer.push_back((unsigned char)trace_rehash);
+			put_varint(capacity);
+			written();
+		}
+
+		void flush() {
+			if (!buffer.empty())
+				out.write((const char*)buffer.data(), buffer.size());
+			buffer.clear();
+			out.flush();
+		}
+
+	private:
+		static const size_t BUFFER_BYTES = 1 << 16;
+
+		std::ofstream out;
+		std::vector<unsigned char> buffer;
+		trace_keys keys;
+		uint64_t k0;
+		uint64_t k1;
+		size_t count;
+
+		void written() {
+			count++;
+			if (buffer.size() >= BUFFER_BYTES) {
+				out.write((const char*)buffer.data(), buffer.size());
+				buffer.clear();
+			}
+		}
+
+		static uint64_t zigzag(int64_t value) {
+			return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+		}
+
+		static int64_t raw_key(const V& value) {
+			if constexpr (raw_available)
+				return (int64_t)value;
+			else
+				return 0;
+		}
+
+		//SipHash with a key that is not stored, so hashed traces do not reveal their keys.
+		//Types siphash cannot read bytewise go through their default_hash first
+		uint64_t hashed_key(const V& value) const {
+			if constexpr (byte_key<V>::available)
+				return byte_key<V>::hash(value, k0, k1);
+			else {
+				uint64_t h = default_hash<V>()(value);
+				return siphash(&h, sizeof(h), k0, k1);
+			}
+		}
+
+		void put_varint(uint64_t value) {
+			while (value >= 0x80) {
+				buffer.push_back((unsigned char)(value | 0x80));
+				value >>= 7;
+			}
+			buffer.push_back((unsigned char)value);
+		}
+
+		void put_fixed(uint64_t value) {
+			for (int i = 0; i < 8; i++)
+				buffer.push_back((unsigned char)(value >> (8 * i)));
+		}
+};
+
+//loads a whole trace. Returns false for a missing file, a wrong header or a truncated record,
+//the records before a truncated one are kept
+inline bool read_trace(const std::string& path, trace& result) {
+	result.records.clear();
+	std::ifstream in(path, std::ios::binary);
+	std::vector<unsigned char> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+	if (bytes.size() < 8 || !std::equal(TRACE_MAGIC, TRACE_MAGIC + 4, bytes.begin()) ||
+		bytes[4] != TRACE_VERSION || bytes[5] > trace_hashed_keys)
+		return false;
+	result.keys = (trace_keys)bytes[5];
+
+	size_t i = 8;
+	while (i < bytes.size()) {
+		unsigned char kind = bytes[i++];
+		if (kind > trace_rehash)
+			return false;
+		uint64_t key = 0;
+		if (kind != trace_rehash && result.keys == trace_hashed_keys) {
+			if (bytes.size() - i < 8)
+				return false;
+			for (int b = 0; b < 8; b++)
+				key |= (uint64_t)bytes[i++] << (8 * b);
+		} else {
+			int shift = 0;
+			while (true) {
+				if (i == bytes.size() || shift > 63)
+					return false;
+				unsigned char byte = bytes[i++];
+				key |= (uint64_t)(byte & 0x7f) << shift;
+				shift += 7;
+				if (byte < 0x80)
+					break;
+			}
+			if (kind != trace_rehash)
+				key = (key >> 1) ^ (0 - (key & 1));
+		}
+		result.records.push_back({ (trace_kind)kind, key });
+	}
+	return true;
+}
+
+//table wrapper that records insert, erase, contains and rehash calls while a writer is attached.
+//Without a writer every call costs one extra branch. Rehashes the table does by itself are not
+//recorded, a replay reproduces them from the inserts
+template<typename Table, typename V = typename std::remove_const<typename Table::value_type>::type>
+class recorded_table {
+
+	public:
+		explicit recorded_table(size_t capacity) : ht(capacity), writer(nullptr) {}
+
+		//starts recording into writer, or stops with nullptr
+		void record_to(trace_writer<V>* writer) {
+			this->writer = writer;
+		}
+
+		void insert(const V& value) {
+			if (writer)
+				writer->record(trace_insert, value);
+			ht.insert(value);
+		}
+
+		void erase(const V& value) {
+			if (writer)
+				writer->record(trace_erase, value);
+			ht.erase(value);
+		}
+
+		bool contains(const V& value) const {
+			if (writer)
+				writer->record(trace_contains, value);
+			return ht.contains(value);
+		}
+
+		void rehash(size_t new_n_buckets) {
+			if (writer)
+				writer->record_rehash(new_n_buckets);
+			ht.rehash(new_n_buckets);
+		}
+
+		size_t size() const {
+			return ht.size();
+		}
+
+		size_t capacity() const {
+			return ht.capacity();
+		}
+
+		//the wrapped table, calls through it are not recorded
+		Table& table() {
+			return ht;
+		}
+
+		const Table& table() const {
+			return ht;
+		}
+
+	private:
+		Table ht;
+		trace_writer<V>* writer;
+};
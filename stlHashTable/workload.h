@@ -0,0 +1,253 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+#include "hash.h"
+#include "instrumentation.h"
+#include "parallel.h"
+
+
+
+//multithreaded load generator for the tables. Every thread draws keys from [0, key_space) with one of
+//the distributions below and runs a mix of contains, insert and erase on a shared table. The tables are
+//not thread safe, locked_table puts one behind a mutex, which is what most callers do today.
+//The latency of every operation is recorded, including the wait for the lock
+enum key_distribution {
+	uniform_keys,
+	zipfian_keys, //rank r is drawn with probability ~ 1 / (r + 1)^skew, key 0 is the hottest
+	hotspot_keys, //hot_operations of the operations go to the first hot_keys of the key space
+	sequential_keys //every thread walks the key space from its own offset
+};
+
+struct workload_config {
+	unsigned threads = 1;
+	size_t key_space = 1000000;
+	key_distribution distribution = uniform_keys;
+	double skew = 0.99; //zipfian, in [0, 1)
+	double hot_keys = 0.2; //hotspot, fraction of the key space
+	double hot_operations = 0.8; //hotspot, fraction of the operations
+	//mix of the operations, normalized by their sum
+	double reads = 0.9;
+	double inserts = 0.05;
+	double erases = 0.05;
+	size_t operations = 1000000; //per thread
+	double prefill = 0.5; //fraction of the key space inserted before the threads start
+};
+
+//keys of one thread. zeta_n is zeta(key_space, skew), only needed for zipfian keys and computed once
+//for all threads (Gray et al., "Quickly generating billion-record synthetic databases")
+class key_generator {
+
+	public:
+		key_generator(const workload_config& config, unsigned thread, double zeta_n = 0);
+
+		uint64_t next();
+		//uniform in [0, 1)
+		double next_unit();
+
+		//sum of 1 / i^theta for i in [1, n]
+		static double zeta(size_t n, double theta);
+
+	private:
+		key_distribution distribution;
+		size_t key_space;
+		uint64_t state;
+		uint64_t position; //sequential
+		size_t hot_size; //hotspot
+		double hot_operations;
+		double theta, zeta_n, alpha, eta, half_pow; //zipfian
+
+		uint64_t next_random();
+};
+
+enum workload_operation {
+	workload_contains,
+	workload_insert,
+	workload_erase
+};
+
+//all operations of a table behind one mutex
+template<typename Table>
+class locked_table {
+
+	public:
+		explicit locked_table(Table& table) : table(table) {}
+
+		void insert(uint64_t key);
+		void erase(uint64_t key);
+		bool contains(uint64_t key);
+
+	private:
+		Table& table;
+		std::mutex lock;
+};
+
+struct workload_result {
+	unsigned threads;
+	size_t operations;
+	size_t hits; //contains() that found the key
+	double seconds;
+	latency_histogram latencies;
+
+	double operations_per_second() const {
+		return seconds > 0 ? operations / seconds : 0;
+	}
+};
+
+//prefills table and runs config.threads threads of config.operations operations each against it.
+//Table needs insert, erase and contains and must be safe for concurrent use, e.g. a locked_table
+template<typename Table>
+workload_result run_workload(Table& table, const workload_config& config);
+
+//==========  DEFINITION OF KEY GENERATOR ==============
+
+inline key_generator::key_generator(const workload_config& config, unsigned thread, double zeta_n) {
+	distribution = config.distribution;
+	key_space = std::max<size_t>(config.key_space, 1);
+	state = mix64(0x5bd1e995 + thread) | 1;
+	position = (uint64_t)key_space * thread / std::max(config.threads, 1u);
+	hot_size = std::max<size_t>((size_t)(key_space * config.hot_keys), 1);
+	hot_operations = config.hot_operations;
+
+	theta = std::min(std::max(config.skew, 0.0), 0.9999);
+	this->zeta_n = zeta_n;
+	alpha = 1 / (1 - theta);
+	half_pow = 1 + std::pow(0.5, theta);
+	eta = 0;
+	if (distribution == zipfian_keys) {
+		if (this->zeta_n == 0)
+			this->zeta_n = zeta(key_space, theta);
+		eta = (1 - std::pow(2.0 / key_space, 1 - theta)) / (1 - zeta(2, theta) / this->zeta_n);
+	}
+}
+
+inline uint64_t key_generator::next() {
+	switch (distribution) {
+	case zipfian_keys: {
+		double u = next_unit();
+		double uz = u * zeta_n;
+		if (uz < 1) return 0;
+		if (uz < half_pow) return std::min<uint64_t>(1, key_space - 1);
+		return std::min<uint64_t>((uint64_t)(key_space * std::pow(eta * u - eta + 1, alpha)), key_space - 1);
+	}
+	case hotspot_keys:
+		if (next_unit() < hot_operations || hot_size >= key_space)
+			return next_random() % hot_size;
+		return hot_size + next_random() % (key_space - hot_size);
+	case sequential_keys: {
+		uint64_t key = position;
+		position = position + 1 == key_space ? 0 : position + 1;
+		return key;
+	}
+	default:
+		return next_random() % key_space;
+	}
+}
+
+inline double key_generator::next_unit() {
+	return (next_random() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+inline double key_generator::zeta(size_t n, double theta) {
+	double sum = 0;
+	for (size_t i = 1; i <= n; i++)
+		sum += 1 / std::pow((double)i, theta);
+	return sum;
+}
+
+inline uint64_t key_generator::next_random() {
+	state ^= state << 13;
+	state ^= state >> 7;
+	state ^= state << 17;
+	return state;
+}
+
+//==========  DEFINITION OF LOCKED TABLE ==============
+
+template<typename Table>
+void locked_table<Table>::insert(uint64_t key) {
+	std::lock_guard<std::mutex> guard(lock);
+	table.insert(key);
+}
+
+template<typename Table>
+void locked_table<Table>::erase(uint64_t key) {
+	std::lock_guard<std::mutex> guard(lock);
+	table.erase(key);
+}
+
+template<typename Table>
+bool table_contains(const Table& table, uint64_t key) {
+	return table.contains(key);
+}
+
+//std::unordered_set has no contains() before C++20
+template<typename H, typename C, typename A>
+bool table_contains(const std::unordered_set<uint64_t, H, C, A>& table, uint64_t key) {
+	return table.count(key) != 0;
+}
+
+template<typename Table>
+bool locked_table<Table>::contains(uint64_t key) {
+	std::lock_guard<std::mutex> guard(lock);
+	return table_contains(table, key);
+}
+
+//==========  DEFINITION OF WORKLOAD ==============
+
+template<typename Table>
+workload_result run_workload(Table& table, const workload_config& config) {
+	unsigned threads = std::max(config.threads, 1u);
+	size_t key_space = std::max<size_t>(config.key_space, 1);
+	for (uint64_t key = 0; key < key_space; key++) {
+		if ((double)(mix64(key) >> 11) * (1.0 / 9007199254740992.0) < config.prefill)
+			table.insert(key);
+	}
+
+	double mix = config.reads + config.inserts + config.erases;
+	double read_share = mix > 0 ? config.reads / mix : 1;
+	double insert_share = mix > 0 ? (config.reads + config.inserts) / mix : 1;
+	double zeta_n = config.distribution == zipfian_keys ? key_generator::zeta(key_space, std::min(std::max(config.skew, 0.0), 0.9999)) : 0;
+
+	//every thread records into its own histogram, they are merged at the end
+	std::vector<latency_histogram> latencies(threads);
+	std::vector<size_t> hits(threads, 0);
+	auto start = std::chrono::steady_clock::now();
+	parallel_for(par(threads), threads, [&](size_t, size_t first, size_t last) {
+		for (size_t thread = first; thread < last; thread++) {
+			key_generator keys(config, (unsigned)thread, zeta_n);
+			latency_histogram& histogram = latencies[thread];
+			size_t found = 0;
+			for (size_t i = 0; i < config.operations; i++) {
+				double u = keys.next_unit();
+				workload_operation operation = u < read_share ? workload_contains : u < insert_share ? workload_insert : workload_erase;
+				uint64_t key = keys.next();
+				uint64_t ticks = tsc_now();
+				if (operation == workload_contains)
+					found += table.contains(key);
+				else if (operation == workload_insert)
+					table.insert(key);
+				else
+					table.erase(key);
+				histogram.record(tsc_now() - ticks);
+			}
+			hits[thread] = found;
+		}
+	});
+
+	workload_result result;
+	result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	result.threads = threads;
+	result.operations = config.operations * threads;
+	result.hits = 0;
+	for (unsigned thread = 0; thread < threads; thread++) {
+		result.latencies.merge(latencies[thread]);
+		result.hits += hits[thread];
+	}
+	return result;
+}